@@ -0,0 +1,159 @@
+/* Timing, spinning, latency-histogram and repetition helpers shared by the
+ * Linux thread benchmarks.
+ *
+ * The histogram is log-linear: values below 2^HIST_SUB_BITS get a bucket each,
+ * every power of two above is split into 2^HIST_SUB_BITS linear sub-buckets,
+ * so percentiles are within about 6% of the recorded value. Units are the
+ * caller's (ticks or ns).
+ *
+ * Repetitions: a benchmark runs reps timed windows, collects one rate per
+ * window and calls summarize_reps() for the median, the window it came from
+ * (so that window's other figures can be reported with it) and the 95%
+ * confidence half-width of the mean. Define SPIN_LIMIT before including to
+ * change how long spin_wait() spins before yielding. */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef SPIN_LIMIT
+#define SPIN_LIMIT 1024
+#endif
+#define HIST_SUB_BITS 4         /* 16 linear sub-buckets per power of two */
+#define HIST_BUCKETS (64 << HIST_SUB_BITS)
+#define MAX_REPS 100
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+typedef struct {
+    double median;              /* Of the per-window rates; mean of the middle two for even reps */
+    double ci;                  /* 95% confidence half-width of the mean rate */
+    int median_rep;             /* Index of the (upper) median window */
+} RepSummary;
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline double get_time_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) ;
+}
+
+/* Bounded spinning: waiters give up the CPU so oversubscribed runs still progress */
+static inline void spin_wait(int* spins) {
+    if (++*spins < SPIN_LIMIT) {
+        cpu_relax();
+    } else {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+static inline int hist_bucket(uint64_t v) {
+    if (v < (1u << HIST_SUB_BITS)) return (int)v;
+    int shift = 63 - __builtin_clzll(v) - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + (int)((v >> shift) & ((1u << HIST_SUB_BITS) - 1));
+}
+
+/* Midpoint of a bucket */
+static inline double hist_value(int bucket) {
+    if (bucket < (1 << HIST_SUB_BITS)) return bucket;
+    int shift = (bucket >> HIST_SUB_BITS) - 1;
+    double low = (double)(((1u << HIST_SUB_BITS) + (bucket & ((1 << HIST_SUB_BITS) - 1)))) * (double)(1ULL << shift);
+    return low + (double)(1ULL << shift) / 2;
+}
+
+static inline double hist_percentile(const long hist[], long total, double pct) {
+    long rank = (long)(pct / 100.0 * total + 0.5), seen = 0;
+    if (rank < 1) rank = 1;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= rank) return hist_value(b);
+    }
+    return 0;
+}
+
+/* Two-sided 95% Student-t critical values: the table for df 1..30, then
+ * 1.96 + 2.4/df, which matches the df 40/60/120 rows (2.021, 2.000, 1.980)
+ * to within 0.001 and tends to the normal 1.960 */
+static inline double t_critical_95(long df) {
+    static const double table[] = {
+        0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) return 0;
+    if (df <= 30) return table[df];
+    return 1.960 + 2.4 / df;
+}
+
+/* n <= MAX_REPS rates, one per timed window; Welford for the variance */
+static inline RepSummary summarize_reps(const double rate[], int n) {
+    RepSummary s = { 0, 0, 0 };
+    int order[MAX_REPS];
+    double mean = 0, m2 = 0;
+
+    if (n < 1) return s;
+    for (int i = 0; i < n; i++) {
+        double delta = rate[i] - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (rate[i] - mean);
+        order[i] = i;
+    }
+
+    /* Insertion sort of window indices by rate: n is at most MAX_REPS */
+    for (int i = 1; i < n; i++) {
+        int k = order[i], j = i;
+        for (; j > 0 && rate[order[j - 1]] > rate[k]; j--) order[j] = order[j - 1];
+        order[j] = k;
+    }
+
+    s.median_rep = order[n / 2];
+    s.median = rate[s.median_rep];
+    if (n % 2 == 0) s.median = (rate[order[n / 2 - 1]] + s.median) / 2;
+    if (n > 1) s.ci = t_critical_95(n - 1) * sqrt(m2 / (n - 1)) / sqrt(n);
+    return s;
+}
+
+/* Parses a comma-separated list of thread counts, each 1..max_threads, into
+ * counts[]; returns how many, or -1 after reporting the bad entry */
+static inline int parse_thread_list(const char* list, int counts[], int max_entries, int max_threads) {
+    char buf[256];
+    int num = 0;
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char* item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+        int n = atoi(item);
+        if (n < 1 || n > max_threads || num == max_entries) {
+            fprintf(stderr, "Bad thread count: %s (1..%d, at most %d entries)\n", item, max_threads, max_entries);
+            return -1;
+        }
+        counts[num++] = n;
+    }
+    return num;
+}
+
+#endif
@@ -0,0 +1,299 @@
+/* Build: gcc -O2 -pthread c2c.c -o c2c -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define MAX_CPUS 1024
+#define MAX_SAMPLES 100
+#define CACHE_LINE 64
+#define SPIN_LIMIT 4096         /* Spins before yielding, only matters when both ends share a CPU */
+#define ITERS 2000              /* Round trips per sample */
+#define SAMPLES 5
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* The line that bounces: odd values are written by ping, even ones by pong */
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long flag;
+    char pad[CACHE_LINE - sizeof(atomic_long)];
+} PaddedLine;
+
+typedef struct {
+    int cpu;
+    long iters;
+    double elapsed_ns;          /* Ping only */
+} PingArg;
+
+PaddedLine line;
+_Alignas(CACHE_LINE) atomic_int ready_count;
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Returns 0 if the measurement was abandoned (flag set to -1) */
+static inline int wait_for(long value) {
+    int spins = 0;
+    long seen;
+    while ((seen = atomic_load_explicit(&line.flag, memory_order_acquire)) != value) {
+        if (seen < 0) return 0;
+        if (++spins < SPIN_LIMIT) {
+            cpu_relax();
+        } else {
+            spins = 0;
+            sched_yield();
+        }
+    }
+    return 1;
+}
+
+static void wait_ready(void) {
+    atomic_fetch_add(&ready_count, 1);
+    while (atomic_load(&ready_count) < 2) cpu_relax();
+}
+
+void* pong(void* arg) {
+    PingArg* a = arg;
+    wait_ready();
+    for (long k = 0; k < a->iters; k++) {
+        if (!wait_for(2 * k + 1)) break;
+        atomic_store_explicit(&line.flag, 2 * k + 2, memory_order_release);
+    }
+    return NULL;
+}
+
+void* ping(void* arg) {
+    PingArg* a = arg;
+    wait_ready();
+    uint64_t start = monotonic_ns();
+    for (long k = 0; k < a->iters; k++) {
+        atomic_store_explicit(&line.flag, 2 * k + 1, memory_order_release);
+        wait_for(2 * k + 2);
+    }
+    a->elapsed_ns = (double)(monotonic_ns() - start);
+    return NULL;
+}
+
+static int spawn_pinned(pthread_t* thread, int cpu, void* (*fn)(void*), void* arg) {
+    pthread_attr_t attr;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_attr_init(&attr);
+    pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    int rc = pthread_create(thread, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+/* One sample: iters round trips of the line between cpu a and cpu b; returns
+ * the one-way latency (half a round trip) in ns */
+double measure_pair(int a, int b, long iters) {
+    pthread_t threads[2];
+    PingArg pi = { a, iters, 0 }, po = { b, iters, 0 };
+
+    atomic_store(&line.flag, 0);
+    atomic_store(&ready_count, 0);
+    if (spawn_pinned(&threads[1], b, pong, &po) != 0) return -1;
+    if (spawn_pinned(&threads[0], a, ping, &pi) != 0) {
+        atomic_store(&line.flag, -1);
+        atomic_fetch_add(&ready_count, 1);
+        pthread_join(threads[1], NULL);
+        return -1;
+    }
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    return pi.elapsed_ns / (2.0 * iters);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Parses a CPU list such as "0-3,8,10-11" */
+static int parse_cpu_list(const char* list, int cpus[], int max) {
+    char buf[4096];
+    int count = 0;
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char* tok = strtok(buf, ",\n"); tok && count < max; tok = strtok(NULL, ",\n")) {
+        int lo, hi;
+        if (sscanf(tok, "%d-%d", &lo, &hi) == 2) {
+            for (int c = lo; c <= hi && count < max; c++) cpus[count++] = c;
+        } else if (sscanf(tok, "%d", &lo) == 1) {
+            cpus[count++] = lo;
+        }
+    }
+    return count;
+}
+
+static int allowed_cpus(int cpus[], int max) {
+    cpu_set_t set;
+    int count = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    for (int c = 0; c < CPU_SETSIZE && count < max; c++)
+        if (CPU_ISSET(c, &set)) cpus[count++] = c;
+    return count;
+}
+
+/* Greedy order for contended threads: start at the pair with the cheapest
+ * transfer, then keep adding the CPU with the lowest mean latency to the group */
+static void nearest_order(const double* lat, int n, int order[]) {
+    int used[MAX_CPUS] = { 0 };
+    int best_a = 0, best_b = n > 1 ? 1 : 0;
+
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            if (lat[i * n + j] < lat[best_a * n + best_b]) {
+                best_a = i;
+                best_b = j;
+            }
+    order[0] = best_a;
+    used[best_a] = 1;
+    if (n > 1) {
+        order[1] = best_b;
+        used[best_b] = 1;
+    }
+
+    for (int k = 2; k < n; k++) {
+        int pick = -1;
+        double pick_cost = 0;
+        for (int c = 0; c < n; c++) {
+            if (used[c]) continue;
+            double cost = 0;
+            for (int g = 0; g < k; g++) cost += lat[c * n + order[g]];
+            if (pick < 0 || cost < pick_cost) {
+                pick = c;
+                pick_cost = cost;
+            }
+        }
+        order[k] = pick;
+        used[pick] = 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    int cpus[MAX_CPUS], n = 0;
+    long iters = ITERS;
+    int samples = SAMPLES;
+    const char* out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            n = parse_cpu_list(argv[++i], cpus, MAX_CPUS);
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = atol(argv[++i]);
+            if (iters < 1) iters = 1;
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = atoi(argv[++i]);
+            if (samples < 1) samples = 1;
+            if (samples > MAX_SAMPLES) samples = MAX_SAMPLES;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--cpus LIST] [--iters N] [--samples N] [--out FILE]\n"
+                    "Measures one-way cache-line transfer latency between every pair of CPUs;\n"
+                    "--out writes the matrix for mutex --c2c FILE\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n == 0) n = allowed_cpus(cpus, MAX_CPUS);
+    if (n < 2) {
+        fprintf(stderr, "Need at least two CPUs (have %d); pass --cpus to choose them\n", n);
+        return 1;
+    }
+
+    double* lat = calloc((size_t)n * n, sizeof(double));
+    double* pairs = malloc(sizeof(double) * n * (n - 1) / 2);
+    double sample[MAX_SAMPLES];
+    if (!lat || !pairs) {
+        perror("malloc");
+        free(lat);
+        free(pairs);
+        return 1;
+    }
+
+    /* Ping-pong is symmetric, so each pair is measured once and mirrored */
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            for (int s = 0; s < samples; s++) sample[s] = measure_pair(cpus[i], cpus[j], iters);
+            qsort(sample, samples, sizeof(double), compare_double);
+            if (sample[0] < 0) {
+                fprintf(stderr, "Cannot pin to CPU %d or %d\n", cpus[i], cpus[j]);
+                free(lat);
+                free(pairs);
+                return 1;
+            }
+            lat[i * n + j] = lat[j * n + i] = sample[samples / 2];
+        }
+        fprintf(stderr, "\rCPU %d of %d", i + 1, n);
+    }
+    fprintf(stderr, "\r%20s\r", "");
+
+    printf("Linux Core-to-Core Latency (one-way ns per cache-line transfer: median of %d x %ld round trips)\n\n",
+           samples, iters);
+
+    printf("%5s", "CPU");
+    for (int j = 0; j < n; j++) printf(" %5d", cpus[j]);
+    printf("\n");
+    for (int i = 0; i < n; i++) {
+        printf("%5d", cpus[i]);
+        for (int j = 0; j < n; j++) {
+            if (i == j) printf(" %5s", "-");
+            else printf(" %5.0f", lat[i * n + j]);
+        }
+        printf("\n");
+    }
+
+    int num_pairs = 0;
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++) pairs[num_pairs++] = lat[i * n + j];
+    qsort(pairs, num_pairs, sizeof(double), compare_double);
+    printf("\nPairs: %d, min %.0f ns, median %.0f ns, max %.0f ns\n",
+           num_pairs, pairs[0], pairs[num_pairs / 2], pairs[num_pairs - 1]);
+
+    int order[MAX_CPUS];
+    nearest_order(lat, n, order);
+    printf("Nearest-first order for contended threads:");
+    for (int k = 0; k < n; k++) printf(" %d", cpus[order[k]]);
+    printf("\n");
+
+    if (out_path) {
+        FILE* fp = fopen(out_path, "w");
+        if (!fp) {
+            perror(out_path);
+            free(lat);
+            free(pairs);
+            return 1;
+        }
+        fprintf(fp, "# c2c one-way cache-line transfer latency, ns\ncpus %d\n", n);
+        for (int j = 0; j < n; j++) fprintf(fp, "%d%c", cpus[j], j + 1 < n ? ' ' : '\n');
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++) fprintf(fp, "%.1f%c", lat[i * n + j], j + 1 < n ? ' ' : '\n');
+        fclose(fp);
+        printf("Matrix written to %s\n", out_path);
+    }
+
+    free(lat);
+    free(pairs);
+    return 0;
+}
@@ -1,10 +1,17 @@
+/* Build: gcc -O2 -pthread cw11.c -o cw11 -lm */
 
-
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include "bench_common.h"
 
 #define MAX_PROCESSES 100
 #define MAX_QUEUE_SIZE 100
@@ -13,17 +20,25 @@
 #define CONTEXT_SWITCH_PENALTY 0.1  /* Linux: 0.1ms context switch overhead */
 #define MAX_GANTT_ENTRIES 1000
 #define MAX_ALGORITHMS 5
+#define MAX_PRIORITY_LEVELS 10  /* Priority values 0-9, one PRR queue each */
+#define WRITER_BUFFER_SIZE (64 * 1024)  /* Streaming writer chunk size */
+#define MAX_WORKER_THREADS 256
+#define MC_CHUNK 64              /* Replicas claimed per atomic fetch */
+#define MC_METRICS 7
+#define MAX_TUNER_QUANTUM 1000
+#define TUNER_INFEASIBLE 1e12
+#define GOLDEN_RATIO 0.6180339887498949
 
-/* ANSI Colors */
-#define COLOR_RESET   "\033[0m"
-#define COLOR_RED     "\033[31m"
-#define COLOR_GREEN   "\033[32m"
-#define COLOR_YELLOW  "\033[33m"
-#define COLOR_BLUE    "\033[34m"
-#define COLOR_MAGENTA "\033[35m"
-#define COLOR_CYAN    "\033[36m"
-#define COLOR_WHITE   "\033[37m"
-#define COLOR_BOLD    "\033[1m"
+/* ANSI Colors (empty strings when output is not a terminal or --no-color) */
+#define COLOR_RESET   (use_color ? "\033[0m"  : "")
+#define COLOR_RED     (use_color ? "\033[31m" : "")
+#define COLOR_GREEN   (use_color ? "\033[32m" : "")
+#define COLOR_YELLOW  (use_color ? "\033[33m" : "")
+#define COLOR_BLUE    (use_color ? "\033[34m" : "")
+#define COLOR_MAGENTA (use_color ? "\033[35m" : "")
+#define COLOR_CYAN    (use_color ? "\033[36m" : "")
+#define COLOR_WHITE   (use_color ? "\033[37m" : "")
+#define COLOR_BOLD    (use_color ? "\033[1m"  : "")
 
 #define CHAR_ARROW "→"
 #define CHAR_CHECK "✓"
@@ -52,9 +67,33 @@ typedef struct {
     double end_time;
 } GanttEntry;
 
+/* Buffered streaming writer: output is flushed in fixed-size chunks so
+ * large exports never hold the whole document in memory */
+typedef struct {
+    FILE* fp;
+    char buf[WRITER_BUFFER_SIZE];
+    size_t len;
+    int failed;             /* A write came up short; sticky until bw_init */
+} BufferedWriter;
+
+/* Chrome Trace Event exporter (loadable in ui.perfetto.dev / chrome://tracing).
+ * Each algorithm run is one trace "process"; tid 0 is the CPU timeline and
+ * tid i+1 carries the Ready/Running states of simulated process i. */
+typedef struct {
+    BufferedWriter out;
+    long events;
+    int run_id;
+    int n;
+    char pids[MAX_PROCESSES][10];
+    double ready_since[MAX_PROCESSES];
+    GanttEntry pending;     /* Last CPU slice, extended while contiguous */
+    int has_pending;
+} TraceExporter;
+
 typedef struct {
     GanttEntry entries[MAX_GANTT_ENTRIES];
     int count;
+    TraceExporter* trace;   /* Optional: receives every slice, uncapped */
 } GanttChart;
 
 typedef struct {
@@ -80,9 +119,93 @@ typedef struct {
     double cs_overhead_percent;
 } PerformanceMetrics;
 
+/* Report backends: human-readable text or machine-readable CSV/JSON */
+typedef enum {
+    REPORT_TEXT,
+    REPORT_CSV,
+    REPORT_JSON
+} ReportFormat;
+
+/* Welford running mean/variance; partial results merge after join */
+typedef struct {
+    long n;
+    double mean;
+    double m2;
+} RunningStats;
+
+/* Seeded synthetic workload: Poisson arrivals, exponential bursts */
+typedef struct {
+    long replicas;
+    int n;                  /* Processes per replica */
+    uint64_t seed;
+    int threads;
+    double mean_interarrival;
+    double mean_burst;
+    int max_burst;
+    int priority_levels;
+} MonteCarloConfig;
+
+/* Quantum search for RR / PRR under a context-switch overhead budget */
+typedef struct {
+    int prr;                /* 0 = round robin, 1 = priority round robin */
+    double cs_budget;       /* Max mean cs_overhead_percent */
+    int qmax;
+    int per_priority;
+    MonteCarloConfig workload;  /* replicas == 0: built-in scenario */
+} TunerConfig;
+
+typedef struct {
+    double p99_response;
+    double mean_response;
+    double cs_overhead;
+} TunerResult;
+
+/* Full engine state between two scheduling steps (see sim_save / sim_load) */
+typedef struct {
+    int algorithm;          /* Index into algorithms[] */
+    Process* processes;
+    int n;
+    GanttChart* gc;
+    int quanta[MAX_PRIORITY_LEVELS];
+    double current_time;
+    int completed;
+    int index;              /* Next process to admit (FCFS: next to run) */
+    int cs_count;
+    int last_process;
+    Queue queues[MAX_PRIORITY_LEVELS];  /* RR uses queues[0] only */
+    long steps;
+} SimState;
+
+/* Options for a single checkpointed run (--algo / --checkpoint / --resume) */
+typedef struct {
+    int algorithm;
+    const char* path;       /* Snapshot written here */
+    long every;             /* Steps between snapshots, 0 = never */
+    long stop_after;        /* Stop and snapshot after this many steps, 0 = run to end */
+    const char* resume_path;
+    int quantum;            /* Override quanta for what-if forks, 0 = keep */
+} CheckpointConfig;
+
+typedef int (*SchedulerFn)(Process processes[], int n, GanttChart* gc);
+typedef int (*SimStepFn)(SimState* s);
+
+typedef struct {
+    const char* name;
+    const char* key;        /* Command-line name */
+    SchedulerFn run;
+    SimStepFn step;
+    int sort_by_arrival;
+} Algorithm;
+
+enum { ALGO_FCFS, ALGO_SRTF, ALGO_RR, ALGO_PRIORITY, ALGO_PRR };
+
 PerformanceMetrics comparison_table[MAX_ALGORITHMS];
 int comparison_count = 0;
 
+int use_color = 1;
+ReportFormat report_format = REPORT_TEXT;
+BufferedWriter report_out;
+
 /* Function prototypes */
 void init_process(Process* p, const char* pid, int arrival, int burst, int priority, const char* role);
 void copy_processes(Process src[], Process dest[], int n);
@@ -98,87 +221,231 @@ void calculate_metrics(Process processes[], int n, int cs_count, PerformanceMetr
 void print_metrics(const char* algorithm, Process processes[], int n, int cs_count, double exec_time);
 void init_gantt(GanttChart* gc);
 void add_gantt_entry(GanttChart* gc, const char* pid, double start, double end);
+void add_context_switch(GanttChart* gc, const char* from, const char* to, double at);
 void print_gantt_chart_linux(GanttChart* gc);
 void print_comparison_summary();
+PerformanceMetrics* record_metrics(const char* algorithm, Process processes[], int n, int cs_count, double exec_time);
+void report_begin();
+void report_run(const char* algorithm, Process processes[], int n, int cs_count, double exec_time, GanttChart* gc);
+void report_end();
+
+/* Monte Carlo replicas */
+uint64_t rng_next(uint64_t* state);
+double rng_uniform(uint64_t* state);
+void generate_workload(const MonteCarloConfig* cfg, long replica, Process processes[]);
+void stats_add(RunningStats* s, double x);
+void stats_merge(RunningStats* into, const RunningStats* from);
+int run_monte_carlo(const MonteCarloConfig* cfg);
+
+/* Quantum tuner */
+int init_default_workload(Process processes[]);
+int evaluate_quanta(const TunerConfig* cfg, const Process* fixed, int fixed_n, const int quanta[], TunerResult* result);
+int run_quantum_tuner(const TunerConfig* cfg);
 void print_linux_header();
 int compare_arrival(const void* a, const void* b);
 
+/* Buffered writer and trace export */
+void bw_init(BufferedWriter* w, FILE* fp);
+void bw_flush(BufferedWriter* w);
+void bw_write(BufferedWriter* w, const char* data, size_t len);
+void bw_puts(BufferedWriter* w, const char* str);
+void bw_printf(BufferedWriter* w, const char* fmt, ...);
+void bw_json_string(BufferedWriter* w, const char* str);
+TraceExporter* trace_open(const char* path);
+int trace_close(TraceExporter* t);
+void trace_begin_run(TraceExporter* t, const char* algorithm, Process processes[], int n);
+void trace_end_run(TraceExporter* t, Process processes[], int n);
+void trace_slice(TraceExporter* t, const char* pid, double start, double end);
+void trace_context_switch(TraceExporter* t, const char* from, const char* to, double at);
+
 /* Scheduling algorithms with context switching tracking */
 int fcfs_linux(Process processes[], int n, GanttChart* gc);
 int srtf_linux(Process processes[], int n, GanttChart* gc);  /* Preemptive */
 int round_robin_linux(Process processes[], int n, GanttChart* gc);
 int priority_preemptive_linux(Process processes[], int n, GanttChart* gc);
 int prr_linux(Process processes[], int n, GanttChart* gc);
+int round_robin_quantum(Process processes[], int n, GanttChart* gc, int quantum);
+int prr_quanta(Process processes[], int n, GanttChart* gc, const int quanta[MAX_PRIORITY_LEVELS]);
+
+/* Step engine and checkpoints */
+int fcfs_step(SimState* s);
+int srtf_step(SimState* s);
+int round_robin_step(SimState* s);
+int priority_step(SimState* s);
+void sim_init(SimState* s, int algorithm, Process processes[], int n, GanttChart* gc,
+              const int quanta[MAX_PRIORITY_LEVELS]);
+int sim_run(SimState* s);
+int sim_save(const SimState* s, const char* path);
+int sim_load(SimState* s, const char* path, Process processes[], GanttChart* gc);
+int run_checkpointed(const CheckpointConfig* cfg, Process workload[], int n);
+
+static const Algorithm algorithms[MAX_ALGORITHMS] = {
+    { "FCFS (Linux)",                "fcfs",     fcfs_linux,                fcfs_step,        1 },
+    { "SRTF - Preemptive (Linux)",   "srtf",     srtf_linux,                srtf_step,        0 },
+    { "Round Robin q=2ms (Linux)",   "rr",       round_robin_linux,         round_robin_step, 1 },
+    { "Priority Preemptive (Linux)", "priority", priority_preemptive_linux, priority_step,    0 },
+    { "Priority RR q=2ms (Linux)",   "prr",      prr_linux,                 round_robin_step, 1 },
+};
 
 /* ==================================================================================
  * MAIN FUNCTION
  * ================================================================================== */
-int main() {
-    printf("\033[2J\033[H");
+int main(int argc, char* argv[]) {
+    const char* trace_path = NULL;
+    MonteCarloConfig mc = { 0, 5, 42, 0, 2.0, 6.0, 20, 5 };
+    TunerConfig tuner = { -1, 5.0, 20, 0, { 0 } };
+    CheckpointConfig checkpoint = { -1, NULL, 0, 0, NULL, 0 };
+    int synthetic = 0;
+    use_color = isatty(STDOUT_FILENO);
     
-    Process original_processes[5];
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "csv") == 0) report_format = REPORT_CSV;
+            else if (strcmp(argv[i], "json") == 0) report_format = REPORT_JSON;
+            else if (strcmp(argv[i], "text") == 0) report_format = REPORT_TEXT;
+            else {
+                fprintf(stderr, "Unknown format: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-color") == 0) {
+            use_color = 0;
+        } else if (strcmp(argv[i], "--monte-carlo") == 0 && i + 1 < argc) {
+            mc.replicas = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--procs") == 0 && i + 1 < argc) {
+            mc.n = atoi(argv[++i]);
+            synthetic = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            mc.seed = strtoull(argv[++i], NULL, 0);
+            synthetic = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            mc.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "rr") == 0) tuner.prr = 0;
+            else if (strcmp(argv[i], "prr") == 0) tuner.prr = 1;
+            else {
+                fprintf(stderr, "Unknown tuning target: %s (rr or prr)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cs-budget") == 0 && i + 1 < argc) {
+            tuner.cs_budget = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--qmax") == 0 && i + 1 < argc) {
+            tuner.qmax = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--per-priority") == 0) {
+            tuner.per_priority = 1;
+        } else if (strcmp(argv[i], "--algo") == 0 && i + 1 < argc) {
+            i++;
+            for (int a = 0; a < MAX_ALGORITHMS; a++) {
+                if (strcmp(argv[i], algorithms[a].key) == 0) checkpoint.algorithm = a;
+            }
+            if (checkpoint.algorithm < 0) {
+                fprintf(stderr, "Unknown algorithm: %s (fcfs, srtf, rr, priority, prr)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint.path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpoint.every = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--stop-after") == 0 && i + 1 < argc) {
+            checkpoint.stop_after = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            checkpoint.resume_path = argv[++i];
+        } else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc) {
+            checkpoint.quantum = atoi(argv[++i]);
+            if (checkpoint.quantum < 1) {
+                fprintf(stderr, "--quantum must be at least 1\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--format text|csv|json] [--no-color] [--trace FILE.json]\n"
+                    "          [--monte-carlo K [--procs N] [--seed S] [--threads T]]\n"
+                    "          [--tune rr|prr [--cs-budget PCT] [--qmax Q] [--per-priority]]\n"
+                    "          [--algo NAME [--procs N] [--seed S] [--quantum Q]\n"
+                    "           [--checkpoint FILE [--checkpoint-every STEPS] [--stop-after STEPS]]]\n"
+                    "          [--resume FILE [--quantum Q] [--checkpoint FILE ...]]\n", argv[0]);
+            return 1;
+        }
+    }
     
-    init_process(&original_processes[0], "P1", 0, 6, 2, "Web Request Handler (Nginx)");
-    init_process(&original_processes[1], "P2", 1, 4, 1, "Authentication Service");
-    init_process(&original_processes[2], "P3", 2, 8, 1, "Database Query Processor");
-    init_process(&original_processes[3], "P4", 0, 3, 4, "Logging & Monitoring Agent");
-    init_process(&original_processes[4], "P5", 3, 10, 5, "Backup/Batch Analytics");
+    if (mc.n < 1 || mc.n > MAX_PROCESSES) {
+        fprintf(stderr, "--procs must be between 1 and %d\n", MAX_PROCESSES);
+        return 1;
+    }
     
-    int n = 5;
+    /* Mode-specific options that would otherwise be silently ignored */
+    if (trace_path && (checkpoint.algorithm >= 0 || checkpoint.resume_path || tuner.prr >= 0 || mc.replicas > 0)) {
+        fprintf(stderr, "--trace only applies to the default algorithm comparison, "
+                "not to --monte-carlo, --tune, --algo or --resume\n");
+        return 1;
+    }
+    if (tuner.per_priority && tuner.prr != 1) {
+        fprintf(stderr, "--per-priority needs --tune prr (round robin has a single quantum)\n");
+        return 1;
+    }
     
-    print_linux_header();
+    if (checkpoint.algorithm >= 0 || checkpoint.resume_path) {
+        Process workload[MAX_PROCESSES];
+        int n = mc.n;
+        if (synthetic) generate_workload(&mc, 0, workload);
+        else n = init_default_workload(workload);
+        return run_checkpointed(&checkpoint, workload, n);
+    }
+    
+    if (tuner.prr >= 0) {
+        if (tuner.qmax < 1) tuner.qmax = 1;
+        if (tuner.qmax > MAX_TUNER_QUANTUM) tuner.qmax = MAX_TUNER_QUANTUM;
+        tuner.workload = mc;
+        return run_quantum_tuner(&tuner);
+    }
+    
+    if (mc.replicas > 0) {
+        return run_monte_carlo(&mc);
+    }
+    
+    TraceExporter* trace = NULL;
+    if (trace_path) {
+        trace = trace_open(trace_path);
+        if (!trace) {
+            perror(trace_path);
+            return 1;
+        }
+    }
+    
+    report_begin();
+    
+    Process original_processes[5];
+    int n = init_default_workload(original_processes);
     
     Process test_procs[MAX_PROCESSES];
     GanttChart gc;
     double start_time, end_time;
     int context_switches;
     
-    /* 1. FCFS */
-    copy_processes(original_processes, test_procs, n);
-    init_gantt(&gc);
-    start_time = get_time_ms();
-    context_switches = fcfs_linux(test_procs, n, &gc);
-    end_time = get_time_ms();
-    print_metrics("FCFS (Linux)", test_procs, n, context_switches, end_time - start_time);
-    print_gantt_chart_linux(&gc);
-    
-    /* 2. SRTF (Preemptive SJF) */
-    copy_processes(original_processes, test_procs, n);
-    init_gantt(&gc);
-    start_time = get_time_ms();
-    context_switches = srtf_linux(test_procs, n, &gc);
-    end_time = get_time_ms();
-    print_metrics("SRTF - Preemptive (Linux)", test_procs, n, context_switches, end_time - start_time);
-    print_gantt_chart_linux(&gc);
-    
-    /* 3. Round Robin */
-    copy_processes(original_processes, test_procs, n);
-    init_gantt(&gc);
-    start_time = get_time_ms();
-    context_switches = round_robin_linux(test_procs, n, &gc);
-    end_time = get_time_ms();
-    print_metrics("Round Robin q=2ms (Linux)", test_procs, n, context_switches, end_time - start_time);
-    print_gantt_chart_linux(&gc);
-    
-    /* 4. Preemptive Priority */
-    copy_processes(original_processes, test_procs, n);
-    init_gantt(&gc);
-    start_time = get_time_ms();
-    context_switches = priority_preemptive_linux(test_procs, n, &gc);
-    end_time = get_time_ms();
-    print_metrics("Priority Preemptive (Linux)", test_procs, n, context_switches, end_time - start_time);
-    print_gantt_chart_linux(&gc);
-    
-    /* 5. PRR */
-    copy_processes(original_processes, test_procs, n);
-    init_gantt(&gc);
-    start_time = get_time_ms();
-    context_switches = prr_linux(test_procs, n, &gc);
-    end_time = get_time_ms();
-    print_metrics("Priority RR q=2ms (Linux)", test_procs, n, context_switches, end_time - start_time);
-    print_gantt_chart_linux(&gc);
-    
-    print_comparison_summary();
+    for (int a = 0; a < MAX_ALGORITHMS; a++) {
+        copy_processes(original_processes, test_procs, n);
+        init_gantt(&gc);
+        gc.trace = trace;
+        trace_begin_run(trace, algorithms[a].name, test_procs, n);
+        start_time = get_time_ms();
+        context_switches = algorithms[a].run(test_procs, n, &gc);
+        end_time = get_time_ms();
+        trace_end_run(trace, test_procs, n);
+        report_run(algorithms[a].name, test_procs, n, context_switches, end_time - start_time, &gc);
+    }
+    
+    report_end();
+    
+    if (trace) {
+        if (trace_close(trace) != 0) {
+            perror(trace_path);
+            return 1;
+        }
+        fprintf(report_format == REPORT_TEXT ? stdout : stderr,
+                "\nTrace written to %s (open in ui.perfetto.dev)\n", trace_path);
+    }
     
     return 0;
 }
@@ -204,6 +471,16 @@ void init_process(Process* p, const char* pid, int arrival, int burst, int prior
     p->context_switches = 0;
 }
 
+/* TechNova backend scenario used by the default report */
+int init_default_workload(Process processes[]) {
+    init_process(&processes[0], "P1", 0, 6, 2, "Web Request Handler (Nginx)");
+    init_process(&processes[1], "P2", 1, 4, 1, "Authentication Service");
+    init_process(&processes[2], "P3", 2, 8, 1, "Database Query Processor");
+    init_process(&processes[3], "P4", 0, 3, 4, "Logging & Monitoring Agent");
+    init_process(&processes[4], "P5", 3, 10, 5, "Backup/Batch Analytics");
+    return 5;
+}
+
 void copy_processes(Process src[], Process dest[], int n) {
     for (int i = 0; i < n; i++) {
         dest[i] = src[i];
@@ -212,9 +489,11 @@ void copy_processes(Process src[], Process dest[], int n) {
 
 void init_gantt(GanttChart* gc) {
     gc->count = 0;
+    gc->trace = NULL;
 }
 
 void add_gantt_entry(GanttChart* gc, const char* pid, double start, double end) {
+    if (gc->trace) trace_slice(gc->trace, pid, start, end);
     if (gc->count >= MAX_GANTT_ENTRIES) return;
     
     if (gc->count > 0 && 
@@ -229,6 +508,10 @@ void add_gantt_entry(GanttChart* gc, const char* pid, double start, double end)
     }
 }
 
+void add_context_switch(GanttChart* gc, const char* from, const char* to, double at) {
+    if (gc->trace) trace_context_switch(gc->trace, from, to, at);
+}
+
 double get_time_ms() {
     struct timeval tv;
     gettimeofday(&tv, NULL);
@@ -272,14 +555,23 @@ int compare_arrival(const void* a, const void* b) {
  * DISPLAY FUNCTIONS
  * ================================================================================== */
 
+/* Builds the rule once and writes it in a single call */
+static void print_rule(char c, int length) {
+    char line[256];
+    if (length > (int)sizeof(line) - 1) length = sizeof(line) - 1;
+    memset(line, c, length);
+    line[length] = '\0';
+    fputs(line, stdout);
+}
+
 void print_separator(int length) {
-    for (int i = 0; i < length; i++) printf("-");
-    printf("\n");
+    print_rule('-', length);
+    putchar('\n');
 }
 
 void print_double_separator(int length) {
-    printf("%s", COLOR_CYAN);
-    for (int i = 0; i < length; i++) printf("=");
+    fputs(COLOR_CYAN, stdout);
+    print_rule('=', length);
     printf("%s\n", COLOR_RESET);
 }
 
@@ -362,14 +654,7 @@ void print_metrics(const char* algorithm, Process processes[], int n, int cs_cou
                temp[i].context_switches, COLOR_RESET);
     }
     
-    PerformanceMetrics metrics;
-    calculate_metrics(processes, n, cs_count, &metrics);
-    strcpy(metrics.algorithm_name, algorithm);
-    metrics.computation_time = exec_time;
-    
-    if (comparison_count < MAX_ALGORITHMS) {
-        comparison_table[comparison_count++] = metrics;
-    }
+    PerformanceMetrics metrics = *record_metrics(algorithm, processes, n, cs_count, exec_time);
     
     printf("\n%s%s Performance Metrics with Context Switching Analysis %s%s\n", 
            COLOR_BOLD, COLOR_GREEN, CHAR_STAR, COLOR_RESET);
@@ -388,6 +673,17 @@ void print_metrics(const char* algorithm, Process processes[], int n, int cs_cou
     printf("Algorithm Computation:        %s%.4f ms%s\n", COLOR_MAGENTA, exec_time, COLOR_RESET);
 }
 
+PerformanceMetrics* record_metrics(const char* algorithm, Process processes[], int n, int cs_count, double exec_time) {
+    static PerformanceMetrics overflow;
+    PerformanceMetrics* metrics = comparison_count < MAX_ALGORITHMS ?
+                                  &comparison_table[comparison_count++] : &overflow;
+    calculate_metrics(processes, n, cs_count, metrics);
+    strncpy(metrics->algorithm_name, algorithm, sizeof(metrics->algorithm_name) - 1);
+    metrics->algorithm_name[sizeof(metrics->algorithm_name) - 1] = '\0';
+    metrics->computation_time = exec_time;
+    return metrics;
+}
+
 void print_gantt_chart_linux(GanttChart* gc) {
     if (gc->count == 0) return;
     
@@ -432,267 +728,1380 @@ void print_comparison_summary() {
 }
 
 /* ==================================================================================
- * SCHEDULING ALGORITHMS WITH CONTEXT SWITCHING
+ * REPORT BACKEND (text / CSV / JSON)
  * ================================================================================== */
 
-int fcfs_linux(Process processes[], int n, GanttChart* gc) {
-    qsort(processes, n, sizeof(Process), compare_arrival);
-    double current_time = 0;
-    int cs_count = 0;
+static void csv_field(BufferedWriter* w, const char* str) {
+    bw_puts(w, "\"");
+    for (const char* c = str; *c; c++) {
+        if (*c == '"') bw_puts(w, "\"\"");
+        else bw_write(w, c, 1);
+    }
+    bw_puts(w, "\"");
+}
+
+static void csv_summary_row(PerformanceMetrics* m) {
+    bw_puts(&report_out, "summary,");
+    csv_field(&report_out, m->algorithm_name);
+    bw_printf(&report_out, ",,,,,,,%.4f,%.4f,%.4f,%d,%.4f,%.4f,%.4f,%.6f,%.4f,%.6f\n",
+              m->avg_turnaround_time, m->avg_waiting_time, m->avg_response_time,
+              m->total_context_switches, m->total_cs_penalty, m->cpu_utilization,
+              m->cs_overhead_percent, m->throughput, m->total_time, m->computation_time);
+}
+
+static void json_metrics(PerformanceMetrics* m) {
+    bw_puts(&report_out, "{\"algorithm\":");
+    bw_json_string(&report_out, m->algorithm_name);
+    bw_printf(&report_out, ",\"avg_turnaround\":%.4f,\"avg_waiting\":%.4f,\"avg_response\":%.4f,"
+              "\"context_switches\":%d,\"cs_penalty\":%.4f,\"effective_cpu_time\":%.4f,"
+              "\"total_time\":%.4f,\"cpu_utilization\":%.4f,\"cs_overhead_percent\":%.4f,"
+              "\"throughput\":%.6f,\"computation_ms\":%.6f}",
+              m->avg_turnaround_time, m->avg_waiting_time, m->avg_response_time,
+              m->total_context_switches, m->total_cs_penalty, m->effective_cpu_time,
+              m->total_time, m->cpu_utilization, m->cs_overhead_percent,
+              m->throughput, m->computation_time);
+}
+
+void report_begin() {
+    static char stdout_buf[WRITER_BUFFER_SIZE];
+    
+    switch (report_format) {
+    case REPORT_CSV:
+        bw_init(&report_out, stdout);
+        bw_puts(&report_out, "record,algorithm,pid,service,arrival,burst,priority,completion,"
+                "turnaround,waiting,response,context_switches,cs_penalty,cpu_utilization,"
+                "cs_overhead_percent,throughput,total_time,computation_ms\n");
+        break;
+    case REPORT_JSON:
+        bw_init(&report_out, stdout);
+        bw_puts(&report_out, "{\"runs\":[");
+        break;
+    default:
+        setvbuf(stdout, stdout_buf, _IOFBF, sizeof(stdout_buf));
+        if (use_color) printf("\033[2J\033[H");
+        print_linux_header();
+        break;
+    }
+}
+
+void report_run(const char* algorithm, Process processes[], int n, int cs_count, double exec_time, GanttChart* gc) {
+    if (report_format == REPORT_TEXT) {
+        print_metrics(algorithm, processes, n, cs_count, exec_time);
+        print_gantt_chart_linux(gc);
+        return;
+    }
+    
+    PerformanceMetrics* m = record_metrics(algorithm, processes, n, cs_count, exec_time);
+    Process temp[MAX_PROCESSES];
+    for (int i = 0; i < n; i++) temp[i] = processes[i];
+    qsort(temp, n, sizeof(Process), compare_arrival);
+    
+    if (report_format == REPORT_CSV) {
+        for (int i = 0; i < n; i++) {
+            bw_puts(&report_out, "process,");
+            csv_field(&report_out, algorithm);
+            bw_puts(&report_out, ",");
+            csv_field(&report_out, temp[i].pid);
+            bw_puts(&report_out, ",");
+            csv_field(&report_out, temp[i].service_role);
+            bw_printf(&report_out, ",%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%d,,,,,,\n",
+                      temp[i].arrival_time, temp[i].burst_time, temp[i].priority,
+                      temp[i].completion_time, temp[i].turnaround_time,
+                      temp[i].waiting_time, temp[i].response_time, temp[i].context_switches);
+        }
+        return;
+    }
     
+    if (comparison_count > 1) bw_puts(&report_out, ",");
+    bw_puts(&report_out, "\n{\"algorithm\":");
+    bw_json_string(&report_out, algorithm);
+    bw_puts(&report_out, ",\"processes\":[");
     for (int i = 0; i < n; i++) {
-        if (i > 0) {
-            current_time += CONTEXT_SWITCH_PENALTY;
-            cs_count++;
+        bw_puts(&report_out, i > 0 ? ",\n  {\"pid\":" : "\n  {\"pid\":");
+        bw_json_string(&report_out, temp[i].pid);
+        bw_puts(&report_out, ",\"service\":");
+        bw_json_string(&report_out, temp[i].service_role);
+        bw_printf(&report_out, ",\"arrival\":%d,\"burst\":%d,\"priority\":%d,\"completion\":%.4f,"
+                  "\"turnaround\":%.4f,\"waiting\":%.4f,\"response\":%.4f,\"context_switches\":%d}",
+                  temp[i].arrival_time, temp[i].burst_time, temp[i].priority,
+                  temp[i].completion_time, temp[i].turnaround_time,
+                  temp[i].waiting_time, temp[i].response_time, temp[i].context_switches);
+    }
+    bw_puts(&report_out, "],\n \"metrics\":");
+    json_metrics(m);
+    bw_puts(&report_out, "}");
+}
+
+void report_end() {
+    switch (report_format) {
+    case REPORT_CSV:
+        for (int i = 0; i < comparison_count; i++) csv_summary_row(&comparison_table[i]);
+        bw_flush(&report_out);
+        break;
+    case REPORT_JSON:
+        bw_puts(&report_out, "],\n\"comparison\":[");
+        for (int i = 0; i < comparison_count; i++) {
+            if (i > 0) bw_puts(&report_out, ",");
+            bw_puts(&report_out, "\n");
+            json_metrics(&comparison_table[i]);
         }
-        
-        if (current_time < processes[i].arrival_time)
-            current_time = processes[i].arrival_time;
-        
-        processes[i].start_time = current_time;
-        processes[i].response_time = current_time - processes[i].arrival_time;
-        processes[i].context_switches = (i > 0) ? 1 : 0;
-        
-        add_gantt_entry(gc, processes[i].pid, current_time, current_time + processes[i].burst_time);
-        current_time += processes[i].burst_time;
-        processes[i].completion_time = current_time;
-        processes[i].turnaround_time = current_time - processes[i].arrival_time;
-        processes[i].waiting_time = processes[i].turnaround_time - processes[i].burst_time;
+        bw_puts(&report_out, "]}\n");
+        bw_flush(&report_out);
+        break;
+    default:
+        print_comparison_summary();
+        break;
     }
+    fflush(stdout);
+}
+
+/* ==================================================================================
+ * SCHEDULING ALGORITHMS WITH CONTEXT SWITCHING
+ *
+ * Each algorithm is a step function over SimState: one call makes one
+ * scheduling decision (or one idle tick) and returns 0 once every process
+ * has completed. Keeping all loop state in SimState is what lets a run be
+ * checkpointed and resumed between any two steps.
+ * ================================================================================== */
+
+void sim_init(SimState* s, int algorithm, Process processes[], int n, GanttChart* gc,
+              const int quanta[MAX_PRIORITY_LEVELS]) {
+    s->algorithm = algorithm;
+    s->processes = processes;
+    s->n = n;
+    s->gc = gc;
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
+        s->quanta[i] = quanta ? quanta[i] : TIME_QUANTUM;
+        init_queue(&s->queues[i]);
+    }
+    s->current_time = 0;
+    s->completed = 0;
+    s->index = 0;
+    s->cs_count = 0;
+    s->last_process = -1;
+    s->steps = 0;
     
-    return cs_count;
+    if (algorithms[algorithm].sort_by_arrival)
+        qsort(processes, n, sizeof(Process), compare_arrival);
+}
+
+int sim_run(SimState* s) {
+    SimStepFn step = algorithms[s->algorithm].step;
+    while (step(s)) s->steps++;
+    return s->cs_count;
+}
+
+int fcfs_linux(Process processes[], int n, GanttChart* gc) {
+    SimState s;
+    sim_init(&s, ALGO_FCFS, processes, n, gc, NULL);
+    return sim_run(&s);
 }
 
 int srtf_linux(Process processes[], int n, GanttChart* gc) {
-    double current_time = 0;
-    int completed = 0;
-    int cs_count = 0;
-    int last_process = -1;
-    
-    while (completed < n) {
-        int shortest = -1;
-        int min_remaining = 99999;
-        
-        for (int i = 0; i < n; i++) {
-            if (!processes[i].is_completed && processes[i].arrival_time <= current_time &&
-                processes[i].remaining_time < min_remaining) {
-                min_remaining = processes[i].remaining_time;
-                shortest = i;
-            }
+    SimState s;
+    sim_init(&s, ALGO_SRTF, processes, n, gc, NULL);
+    return sim_run(&s);
+}
+
+int round_robin_linux(Process processes[], int n, GanttChart* gc) {
+    return round_robin_quantum(processes, n, gc, TIME_QUANTUM);
+}
+
+int round_robin_quantum(Process processes[], int n, GanttChart* gc, int quantum) {
+    SimState s;
+    int quanta[MAX_PRIORITY_LEVELS];
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) quanta[i] = quantum;
+    sim_init(&s, ALGO_RR, processes, n, gc, quanta);
+    return sim_run(&s);
+}
+
+int priority_preemptive_linux(Process processes[], int n, GanttChart* gc) {
+    SimState s;
+    sim_init(&s, ALGO_PRIORITY, processes, n, gc, NULL);
+    return sim_run(&s);
+}
+
+int prr_linux(Process processes[], int n, GanttChart* gc) {
+    return prr_quanta(processes, n, gc, NULL);
+}
+
+/* Priority round robin with an independent quantum per priority level */
+int prr_quanta(Process processes[], int n, GanttChart* gc, const int quanta[MAX_PRIORITY_LEVELS]) {
+    SimState s;
+    sim_init(&s, ALGO_PRR, processes, n, gc, quanta);
+    return sim_run(&s);
+}
+
+int fcfs_step(SimState* s) {
+    Process* processes = s->processes;
+    if (s->index >= s->n) return 0;
+    
+    int i = s->index++;
+    if (i > 0) {
+        add_context_switch(s->gc, processes[i - 1].pid, processes[i].pid, s->current_time);
+        s->current_time += CONTEXT_SWITCH_PENALTY;
+        s->cs_count++;
+    }
+    
+    if (s->current_time < processes[i].arrival_time)
+        s->current_time = processes[i].arrival_time;
+    
+    processes[i].start_time = s->current_time;
+    processes[i].response_time = s->current_time - processes[i].arrival_time;
+    processes[i].context_switches = (i > 0) ? 1 : 0;
+    
+    add_gantt_entry(s->gc, processes[i].pid, s->current_time, s->current_time + processes[i].burst_time);
+    s->current_time += processes[i].burst_time;
+    processes[i].completion_time = s->current_time;
+    processes[i].turnaround_time = s->current_time - processes[i].arrival_time;
+    processes[i].waiting_time = processes[i].turnaround_time - processes[i].burst_time;
+    processes[i].remaining_time = 0;
+    processes[i].is_completed = 1;
+    s->completed++;
+    
+    return 1;
+}
+
+/* Shared tick for SRTF and preemptive priority: run the selected process for 1ms */
+static void run_one_tick(SimState* s, int selected) {
+    Process* processes = s->processes;
+    
+    if (s->last_process != -1 && s->last_process != selected) {
+        add_context_switch(s->gc, processes[s->last_process].pid, processes[selected].pid, s->current_time);
+        s->current_time += CONTEXT_SWITCH_PENALTY;
+        s->cs_count++;
+        processes[selected].context_switches++;
+    }
+    
+    if (processes[selected].response_time == -1) {
+        processes[selected].start_time = s->current_time;
+        processes[selected].response_time = s->current_time - processes[selected].arrival_time;
+    }
+    
+    add_gantt_entry(s->gc, processes[selected].pid, s->current_time, s->current_time + 1);
+    processes[selected].remaining_time--;
+    s->current_time++;
+    
+    if (processes[selected].remaining_time == 0) {
+        processes[selected].completion_time = s->current_time;
+        processes[selected].turnaround_time = s->current_time - processes[selected].arrival_time;
+        processes[selected].waiting_time = processes[selected].turnaround_time - processes[selected].burst_time;
+        processes[selected].is_completed = 1;
+        s->completed++;
+    }
+    
+    s->last_process = selected;
+}
+
+int srtf_step(SimState* s) {
+    Process* processes = s->processes;
+    if (s->completed >= s->n) return 0;
+    
+    int shortest = -1;
+    int min_remaining = 99999;
+    
+    for (int i = 0; i < s->n; i++) {
+        if (!processes[i].is_completed && processes[i].arrival_time <= s->current_time &&
+            processes[i].remaining_time < min_remaining) {
+            min_remaining = processes[i].remaining_time;
+            shortest = i;
         }
-        
-        if (shortest == -1) {
-            current_time++;
-            continue;
+    }
+    
+    if (shortest == -1) {
+        s->current_time++;
+        return 1;
+    }
+    
+    run_one_tick(s, shortest);
+    return 1;
+}
+
+int priority_step(SimState* s) {
+    Process* processes = s->processes;
+    if (s->completed >= s->n) return 0;
+    
+    int highest = -1;
+    int best_priority = 99999;
+    
+    for (int i = 0; i < s->n; i++) {
+        if (!processes[i].is_completed && processes[i].arrival_time <= s->current_time &&
+            processes[i].priority < best_priority) {
+            best_priority = processes[i].priority;
+            highest = i;
         }
-        
-        if (last_process != -1 && last_process != shortest) {
-            current_time += CONTEXT_SWITCH_PENALTY;
-            cs_count++;
-            processes[shortest].context_switches++;
+    }
+    
+    if (highest == -1) {
+        s->current_time++;
+        return 1;
+    }
+    
+    run_one_tick(s, highest);
+    return 1;
+}
+
+/* RR keeps every process in queues[0]; PRR uses one queue per priority level */
+static Queue* ready_queue_for(SimState* s, Process* p) {
+    return s->algorithm == ALGO_PRR ? &s->queues[p->priority] : &s->queues[0];
+}
+
+static void admit_arrivals(SimState* s) {
+    Process* processes = s->processes;
+    while (s->index < s->n && processes[s->index].arrival_time <= s->current_time) {
+        enqueue(ready_queue_for(s, &processes[s->index]), &processes[s->index]);
+        s->index++;
+    }
+}
+
+/* Shared step for RR and PRR: the highest non-empty queue runs for one quantum */
+int round_robin_step(SimState* s) {
+    Process* processes = s->processes;
+    if (s->completed >= s->n) return 0;
+    
+    admit_arrivals(s);
+    
+    int highest_priority = -1;
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
+        if (!is_queue_empty(&s->queues[i])) {
+            highest_priority = i;
+            break;
         }
-        
-        if (processes[shortest].response_time == -1) {
-            processes[shortest].start_time = current_time;
-            processes[shortest].response_time = current_time - processes[shortest].arrival_time;
+    }
+    
+    if (highest_priority == -1) {
+        if (s->index < s->n) s->current_time = processes[s->index].arrival_time;
+        return 1;
+    }
+    
+    Process* p = dequeue(&s->queues[highest_priority]);
+    int p_idx = p - processes;
+    
+    if (s->last_process != -1 && s->last_process != p_idx) {
+        add_context_switch(s->gc, processes[s->last_process].pid, p->pid, s->current_time);
+        s->current_time += CONTEXT_SWITCH_PENALTY;
+        s->cs_count++;
+        p->context_switches++;
+    }
+    
+    if (p->response_time == -1) {
+        p->start_time = s->current_time;
+        p->response_time = s->current_time - p->arrival_time;
+    }
+    
+    int quantum = s->quanta[p->priority];
+    int exec_time = (quantum < p->remaining_time) ? quantum : p->remaining_time;
+    add_gantt_entry(s->gc, p->pid, s->current_time, s->current_time + exec_time);
+    p->remaining_time -= exec_time;
+    s->current_time += exec_time;
+    
+    admit_arrivals(s);
+    
+    if (p->remaining_time > 0) {
+        enqueue(ready_queue_for(s, p), p);
+    } else {
+        p->completion_time = s->current_time;
+        p->turnaround_time = s->current_time - p->arrival_time;
+        p->waiting_time = p->turnaround_time - p->burst_time;
+        p->is_completed = 1;
+        s->completed++;
+    }
+    
+    s->last_process = p_idx;
+    return 1;
+}
+
+/* ==================================================================================
+ * TRACE EXPORT (Chrome Trace Event JSON)
+ * ================================================================================== */
+
+void bw_init(BufferedWriter* w, FILE* fp) {
+    w->fp = fp;
+    w->len = 0;
+    w->failed = 0;
+}
+
+void bw_flush(BufferedWriter* w) {
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->fp) != w->len) w->failed = 1;
+    w->len = 0;
+}
+
+void bw_write(BufferedWriter* w, const char* data, size_t len) {
+    if (w->len + len > WRITER_BUFFER_SIZE) bw_flush(w);
+    if (len > WRITER_BUFFER_SIZE) {
+        if (fwrite(data, 1, len, w->fp) != len) w->failed = 1;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+void bw_puts(BufferedWriter* w, const char* str) {
+    bw_write(w, str, strlen(str));
+}
+
+void bw_printf(BufferedWriter* w, const char* fmt, ...) {
+    char line[1024];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len < 0) return;
+    if ((size_t)len >= sizeof(line)) len = sizeof(line) - 1;
+    bw_write(w, line, len);
+}
+
+void bw_json_string(BufferedWriter* w, const char* str) {
+    bw_puts(w, "\"");
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            char esc[2] = { '\\', *c };
+            bw_write(w, esc, 2);
+        } else if ((unsigned char)*c < 0x20) {
+            bw_printf(w, "\\u%04x", (unsigned char)*c);
+        } else {
+            bw_write(w, c, 1);
         }
+    }
+    bw_puts(w, "\"");
+}
+
+/* Opens the event array; every event is prefixed by a comma except the first */
+static void trace_event_start(TraceExporter* t) {
+    if (t->events++ > 0) bw_puts(&t->out, ",\n");
+}
+
+static int trace_track(TraceExporter* t, const char* pid) {
+    for (int i = 0; i < t->n; i++) {
+        if (strcmp(t->pids[i], pid) == 0) return i;
+    }
+    return -1;
+}
+
+/* Complete event ("X"); simulated milliseconds become trace microseconds */
+static void trace_complete(TraceExporter* t, int tid, const char* name, double start, double end) {
+    trace_event_start(t);
+    bw_puts(&t->out, "{\"name\":");
+    bw_json_string(&t->out, name);
+    bw_printf(&t->out, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+              t->run_id, tid, start * 1000.0, (end - start) * 1000.0);
+}
+
+static void trace_instant(TraceExporter* t, int tid, const char* name, double at) {
+    trace_event_start(t);
+    bw_puts(&t->out, "{\"name\":");
+    bw_json_string(&t->out, name);
+    bw_printf(&t->out, ",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+              t->run_id, tid, at * 1000.0);
+}
+
+static void trace_metadata(TraceExporter* t, const char* kind, int tid, const char* name) {
+    trace_event_start(t);
+    bw_printf(&t->out, "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+              kind, t->run_id, tid);
+    bw_json_string(&t->out, name);
+    bw_puts(&t->out, "}}");
+}
+
+/* Emits the pending CPU slice plus the matching Ready/Running states */
+static void trace_flush_pending(TraceExporter* t) {
+    if (!t->has_pending) return;
+    GanttEntry* e = &t->pending;
+    trace_complete(t, 0, e->pid, e->start_time, e->end_time);
+    
+    int idx = trace_track(t, e->pid);
+    if (idx >= 0) {
+        if (e->start_time > t->ready_since[idx])
+            trace_complete(t, idx + 1, "Ready", t->ready_since[idx], e->start_time);
+        trace_complete(t, idx + 1, "Running", e->start_time, e->end_time);
+        t->ready_since[idx] = e->end_time;
+    }
+    t->has_pending = 0;
+}
+
+TraceExporter* trace_open(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return NULL;
+    
+    TraceExporter* t = malloc(sizeof(TraceExporter));
+    if (!t) {
+        fclose(fp);
+        return NULL;
+    }
+    bw_init(&t->out, fp);
+    t->events = 0;
+    t->run_id = 0;
+    t->n = 0;
+    t->has_pending = 0;
+    bw_printf(&t->out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    return t;
+}
+
+/* Returns -1 (errno set) if any part of the trace failed to reach the file */
+int trace_close(TraceExporter* t) {
+    bw_printf(&t->out, "\n]}\n");
+    bw_flush(&t->out);
+    int rc = t->out.failed || ferror(t->out.fp) ? -1 : 0;
+    if (fclose(t->out.fp) != 0) rc = -1;
+    free(t);
+    return rc;
+}
+
+void trace_begin_run(TraceExporter* t, const char* algorithm, Process processes[], int n) {
+    if (!t) return;
+    t->run_id++;
+    t->n = n;
+    t->has_pending = 0;
+    
+    trace_metadata(t, "process_name", 0, algorithm);
+    trace_metadata(t, "thread_name", 0, "CPU");
+    for (int i = 0; i < n; i++) {
+        char label[MAX_SERVICE_ROLE + 16];
+        snprintf(label, sizeof(label), "%s %s", processes[i].pid, processes[i].service_role);
+        strcpy(t->pids[i], processes[i].pid);
+        t->ready_since[i] = processes[i].arrival_time;
+        trace_metadata(t, "thread_name", i + 1, label);
+        trace_instant(t, i + 1, "Arrived", processes[i].arrival_time);
+    }
+}
+
+void trace_end_run(TraceExporter* t, Process processes[], int n) {
+    if (!t) return;
+    trace_flush_pending(t);
+    for (int i = 0; i < n; i++) {
+        int idx = trace_track(t, processes[i].pid);
+        if (idx >= 0) trace_instant(t, idx + 1, "Completed", processes[i].completion_time);
+    }
+}
+
+void trace_slice(TraceExporter* t, const char* pid, double start, double end) {
+    if (t->has_pending && strcmp(t->pending.pid, pid) == 0 && t->pending.end_time == start) {
+        t->pending.end_time = end;
+        return;
+    }
+    trace_flush_pending(t);
+    strcpy(t->pending.pid, pid);
+    t->pending.start_time = start;
+    t->pending.end_time = end;
+    t->has_pending = 1;
+}
+
+void trace_context_switch(TraceExporter* t, const char* from, const char* to, double at) {
+    trace_flush_pending(t);
+    trace_event_start(t);
+    bw_printf(&t->out, "{\"name\":\"context switch\",\"cat\":\"cs\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,"
+              "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"from\":",
+              t->run_id, at * 1000.0, CONTEXT_SWITCH_PENALTY * 1000.0);
+    bw_json_string(&t->out, from);
+    bw_puts(&t->out, ",\"to\":");
+    bw_json_string(&t->out, to);
+    bw_puts(&t->out, "}}");
+}
+
+
+/* ==================================================================================
+ * MONTE CARLO MODE (parallel replicas, 95% confidence intervals)
+ * ================================================================================== */
+
+static const char* mc_metric_names[MC_METRICS] = {
+    "TAT(ms)", "WT(ms)", "RT(ms)", "CS", "CPU%", "CS OH%", "Thru(p/ms)"
+};
+
+typedef struct {
+    const MonteCarloConfig* cfg;
+    atomic_long* next_replica;
+    RunningStats stats[MAX_ALGORITHMS][MC_METRICS];
+    int failed;             /* Could not allocate its Gantt chart */
+} MonteCarloWorker;
+
+/* splitmix64: tiny, fast and good enough to derive independent streams */
+uint64_t rng_next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double rng_uniform(uint64_t* state) {
+    return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Each replica owns its stream, so results do not depend on the thread count */
+void generate_workload(const MonteCarloConfig* cfg, long replica, Process processes[]) {
+    uint64_t state = cfg->seed ^ ((uint64_t)replica * 0xD1B54A32D192ED03ULL);
+    rng_next(&state);
+    
+    double arrival = 0;
+    for (int i = 0; i < cfg->n; i++) {
+        char pid[16];
+        snprintf(pid, sizeof(pid), "P%d", i + 1);
         
-        add_gantt_entry(gc, processes[shortest].pid, current_time, current_time + 1);
-        processes[shortest].remaining_time--;
-        current_time++;
+        int burst = 1 + (int)(-log(1.0 - rng_uniform(&state)) * (cfg->mean_burst - 1));
+        if (burst > cfg->max_burst) burst = cfg->max_burst;
+        int priority = 1 + (int)(rng_uniform(&state) * cfg->priority_levels);
         
-        if (processes[shortest].remaining_time == 0) {
-            processes[shortest].completion_time = current_time;
-            processes[shortest].turnaround_time = current_time - processes[shortest].arrival_time;
-            processes[shortest].waiting_time = processes[shortest].turnaround_time - processes[shortest].burst_time;
-            processes[shortest].is_completed = 1;
-            completed++;
-        }
+        init_process(&processes[i], pid, (int)arrival, burst, priority, "Synthetic Workload");
+        arrival += -log(1.0 - rng_uniform(&state)) * cfg->mean_interarrival;
+    }
+}
+
+void stats_add(RunningStats* s, double x) {
+    s->n++;
+    double delta = x - s->mean;
+    s->mean += delta / s->n;
+    s->m2 += delta * (x - s->mean);
+}
+
+/* Chan et al. parallel combination of two Welford accumulators */
+void stats_merge(RunningStats* into, const RunningStats* from) {
+    if (from->n == 0) return;
+    if (into->n == 0) {
+        *into = *from;
+        return;
+    }
+    long n = into->n + from->n;
+    double delta = from->mean - into->mean;
+    into->mean += delta * from->n / n;
+    into->m2 += from->m2 + delta * delta * ((double)into->n * from->n / n);
+    into->n = n;
+}
+
+static void* monte_carlo_worker(void* arg) {
+    MonteCarloWorker* w = arg;
+    const MonteCarloConfig* cfg = w->cfg;
+    Process workload[MAX_PROCESSES];
+    Process procs[MAX_PROCESSES];
+    GanttChart* gc = malloc(sizeof(GanttChart));
+    if (!gc) {
+        w->failed = 1;
+        return NULL;
+    }
+    
+    for (;;) {
+        long first = atomic_fetch_add(w->next_replica, MC_CHUNK);
+        if (first >= cfg->replicas) break;
+        long last = first + MC_CHUNK < cfg->replicas ? first + MC_CHUNK : cfg->replicas;
         
-        last_process = shortest;
+        for (long r = first; r < last; r++) {
+            generate_workload(cfg, r, workload);
+            for (int a = 0; a < MAX_ALGORITHMS; a++) {
+                PerformanceMetrics m;
+                copy_processes(workload, procs, cfg->n);
+                init_gantt(gc);
+                int cs = algorithms[a].run(procs, cfg->n, gc);
+                calculate_metrics(procs, cfg->n, cs, &m);
+                
+                double values[MC_METRICS] = {
+                    m.avg_turnaround_time, m.avg_waiting_time, m.avg_response_time,
+                    m.total_context_switches, m.cpu_utilization, m.cs_overhead_percent,
+                    m.throughput
+                };
+                for (int k = 0; k < MC_METRICS; k++) stats_add(&w->stats[a][k], values[k]);
+            }
+        }
     }
     
-    return cs_count;
+    free(gc);
+    return NULL;
 }
 
-int round_robin_linux(Process processes[], int n, GanttChart* gc) {
-    Queue queue;
-    init_queue(&queue);
-    qsort(processes, n, sizeof(Process), compare_arrival);
-    
-    double current_time = 0;
-    int completed = 0;
-    int index = 0;
-    int cs_count = 0;
-    int last_process_idx = -1;
-    
-    while (completed < n) {
-        while (index < n && processes[index].arrival_time <= current_time) {
-            enqueue(&queue, &processes[index]);
-            index++;
-        }
-        
-        if (is_queue_empty(&queue)) {
-            if (index < n) current_time = processes[index].arrival_time;
-            continue;
+int run_monte_carlo(const MonteCarloConfig* cfg) {
+    int threads = cfg->threads > 0 ? cfg->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > MAX_WORKER_THREADS) threads = MAX_WORKER_THREADS;
+    
+    MonteCarloWorker* workers = calloc(threads, sizeof(MonteCarloWorker));
+    pthread_t tids[MAX_WORKER_THREADS];
+    atomic_long next_replica = 0;
+    if (!workers) return 1;
+    
+    double start = get_time_ms();
+    for (int t = 0; t < threads; t++) {
+        workers[t].cfg = cfg;
+        workers[t].next_replica = &next_replica;
+        int rc = pthread_create(&tids[t], NULL, monte_carlo_worker, &workers[t]);
+        if (rc != 0) {
+            /* Hand out no more replicas, so the workers already running finish */
+            atomic_store(&next_replica, cfg->replicas);
+            while (--t >= 0) pthread_join(tids[t], NULL);
+            free(workers);
+            fprintf(stderr, "Monte Carlo: %s\n", strerror(rc));
+            return 1;
         }
-        
-        Process* p = dequeue(&queue);
-        int p_idx = p - processes;
-        
-        if (last_process_idx != -1 && last_process_idx != p_idx) {
-            current_time += CONTEXT_SWITCH_PENALTY;
-            cs_count++;
-            p->context_switches++;
+    }
+    
+    RunningStats total[MAX_ALGORITHMS][MC_METRICS] = {{{ 0 }}};
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        failed |= workers[t].failed;
+        for (int a = 0; a < MAX_ALGORITHMS; a++)
+            for (int k = 0; k < MC_METRICS; k++)
+                stats_merge(&total[a][k], &workers[t].stats[a][k]);
+    }
+    double elapsed = get_time_ms() - start;
+    free(workers);
+    /* The others may have covered its replicas, but the run is not what was asked for */
+    if (failed) {
+        fprintf(stderr, "Monte Carlo: out of memory in a worker thread\n");
+        return 1;
+    }
+    
+    if (report_format != REPORT_TEXT) {
+        bw_init(&report_out, stdout);
+        if (report_format == REPORT_CSV)
+            bw_puts(&report_out, "algorithm,metric,mean,stddev,ci95_low,ci95_high,replicas\n");
+        else
+            bw_printf(&report_out, "{\"replicas\":%ld,\"procs\":%d,\"seed\":%llu,\"results\":[",
+                      cfg->replicas, cfg->n, (unsigned long long)cfg->seed);
+    } else {
+        print_double_separator(145);
+        printf("%s%s      MONTE CARLO - %ld replicas x %d processes (seed %llu, %d threads, %.1f ms)      %s\n",
+               COLOR_BOLD, COLOR_WHITE, cfg->replicas, cfg->n, (unsigned long long)cfg->seed,
+               threads, elapsed, COLOR_RESET);
+        print_double_separator(145);
+        printf("\n%s%-30s", COLOR_BOLD, "Algorithm (mean ± 95% CI)");
+        for (int k = 0; k < MC_METRICS; k++) printf(" %-15s", mc_metric_names[k]);
+        printf("%s\n", COLOR_RESET);
+        print_separator(145);
+    }
+    
+    for (int a = 0; a < MAX_ALGORITHMS; a++) {
+        if (report_format == REPORT_TEXT) printf("%-30s", algorithms[a].name);
+        for (int k = 0; k < MC_METRICS; k++) {
+            RunningStats* s = &total[a][k];
+            double sd = s->n > 1 ? sqrt(s->m2 / (s->n - 1)) : 0;
+            double half = t_critical_95(s->n - 1) * sd / sqrt((double)s->n);
+            
+            if (report_format == REPORT_CSV) {
+                bw_printf(&report_out, "\"%s\",\"%s\",%.6f,%.6f,%.6f,%.6f,%ld\n",
+                          algorithms[a].name, mc_metric_names[k], s->mean, sd,
+                          s->mean - half, s->mean + half, s->n);
+            } else if (report_format == REPORT_JSON) {
+                bw_puts(&report_out, a + k > 0 ? ",\n{\"algorithm\":" : "\n{\"algorithm\":");
+                bw_json_string(&report_out, algorithms[a].name);
+                bw_puts(&report_out, ",\"metric\":");
+                bw_json_string(&report_out, mc_metric_names[k]);
+                bw_printf(&report_out, ",\"mean\":%.6f,\"stddev\":%.6f,\"ci95_low\":%.6f,\"ci95_high\":%.6f}",
+                          s->mean, sd, s->mean - half, s->mean + half);
+            } else {
+                char cell[32];
+                snprintf(cell, sizeof(cell), "%.2f±%.2f", s->mean, half);
+                printf(" %-16s", cell);
+            }
         }
+        if (report_format == REPORT_TEXT) printf("\n");
+    }
+    
+    if (report_format == REPORT_TEXT) {
+        print_double_separator(145);
+    } else {
+        if (report_format == REPORT_JSON) bw_puts(&report_out, "]}\n");
+        bw_flush(&report_out);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+
+/* ==================================================================================
+ * QUANTUM TUNER (golden-section search over parallel simulations)
+ * ================================================================================== */
+
+typedef struct {
+    const TunerConfig* cfg;
+    const Process* fixed;
+    const int* quanta;
+    int n;
+    long replicas;
+    double* response;       /* replicas * n response times, one slot each */
+    atomic_long* next_replica;
+    double overhead_sum;
+    int failed;
+} TunerWorker;
+
+typedef struct {
+    const TunerConfig* cfg;
+    const Process* fixed;
+    int fixed_n;
+    int failed;             /* Error from the evaluation that failed, 0 if none */
+    int quanta[MAX_PRIORITY_LEVELS];
+    int level;              /* -1: all levels share one quantum */
+    int evaluations;
+    TunerResult memo[MAX_TUNER_QUANTUM + 1];   /* Per search axis, reset on level change */
+    unsigned char memo_valid[MAX_TUNER_QUANTUM + 1];
+} TunerSearch;
+
+static void* tuner_worker(void* arg) {
+    TunerWorker* w = arg;
+    Process procs[MAX_PROCESSES];
+    GanttChart* gc = malloc(sizeof(GanttChart));
+    if (!gc) {
+        w->failed = 1;
+        return NULL;
+    }
+    
+    for (;;) {
+        long first = atomic_fetch_add(w->next_replica, MC_CHUNK);
+        if (first >= w->replicas) break;
+        long last = first + MC_CHUNK < w->replicas ? first + MC_CHUNK : w->replicas;
         
-        if (p->response_time == -1) {
-            p->start_time = current_time;
-            p->response_time = current_time - p->arrival_time;
+        for (long r = first; r < last; r++) {
+            PerformanceMetrics m;
+            if (w->fixed) copy_processes((Process*)w->fixed, procs, w->n);
+            else generate_workload(&w->cfg->workload, r, procs);
+            
+            init_gantt(gc);
+            int cs = w->cfg->prr ? prr_quanta(procs, w->n, gc, w->quanta)
+                                 : round_robin_quantum(procs, w->n, gc, w->quanta[0]);
+            calculate_metrics(procs, w->n, cs, &m);
+            w->overhead_sum += m.cs_overhead_percent;
+            for (int i = 0; i < w->n; i++) w->response[r * w->n + i] = procs[i].response_time;
         }
-        
-        int exec_time = (TIME_QUANTUM < p->remaining_time) ? TIME_QUANTUM : p->remaining_time;
-        add_gantt_entry(gc, p->pid, current_time, current_time + exec_time);
-        p->remaining_time -= exec_time;
-        current_time += exec_time;
-        
-        while (index < n && processes[index].arrival_time <= current_time) {
-            enqueue(&queue, &processes[index]);
-            index++;
+    }
+    
+    free(gc);
+    return NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* fixed: the fixed_n processes to simulate once, or NULL for the Monte Carlo
+ * replicas; returns 0, ENOMEM, or the error from pthread_create */
+int evaluate_quanta(const TunerConfig* cfg, const Process* fixed, int fixed_n, const int quanta[], TunerResult* result) {
+    int n = fixed ? fixed_n : cfg->workload.n;
+    long replicas = fixed ? 1 : cfg->workload.replicas;
+    int threads = cfg->workload.threads > 0 ? cfg->workload.threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > MAX_WORKER_THREADS) threads = MAX_WORKER_THREADS;
+    if (threads > replicas) threads = replicas;
+    
+    long samples = replicas * n;
+    double* response = malloc(samples * sizeof(double));
+    TunerWorker* workers = calloc(threads, sizeof(TunerWorker));
+    pthread_t tids[MAX_WORKER_THREADS];
+    atomic_long next_replica = 0;
+    if (!response || !workers) {
+        free(response);
+        free(workers);
+        return ENOMEM;
+    }
+    
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (TunerWorker){ cfg, fixed, quanta, n, replicas, response, &next_replica, 0, 0 };
+        int rc = pthread_create(&tids[t], NULL, tuner_worker, &workers[t]);
+        if (rc != 0) {
+            atomic_store(&next_replica, replicas);
+            while (--t >= 0) pthread_join(tids[t], NULL);
+            free(response);
+            free(workers);
+            return rc;
         }
-        
-        if (p->remaining_time > 0) {
-            enqueue(&queue, p);
-        } else {
-            p->completion_time = current_time;
-            p->turnaround_time = current_time - p->arrival_time;
-            p->waiting_time = p->turnaround_time - p->burst_time;
-            completed++;
+    }
+    
+    double overhead = 0;
+    int failed = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        overhead += workers[t].overhead_sum;
+        failed |= workers[t].failed;
+    }
+    /* A worker that failed may have left response slots unwritten */
+    if (failed) {
+        free(response);
+        free(workers);
+        return ENOMEM;
+    }
+    
+    double sum = 0;
+    for (long i = 0; i < samples; i++) sum += response[i];
+    qsort(response, samples, sizeof(double), compare_double);
+    long rank = (long)ceil(0.99 * samples);
+    
+    result->p99_response = response[rank > 0 ? rank - 1 : 0];
+    result->mean_response = sum / samples;
+    result->cs_overhead = overhead / replicas;
+    free(response);
+    free(workers);
+    return 0;
+}
+
+/* Objective: p99 response time, with budget violations pushed above any feasible point */
+static double tuner_objective(TunerSearch* search, int q, TunerResult* out) {
+    int quanta[MAX_PRIORITY_LEVELS];
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++)
+        quanta[i] = (search->level < 0 || search->level == i) ? q : search->quanta[i];
+    
+    TunerResult r;
+    int feasible;
+    if (search->memo_valid[q]) {
+        r = search->memo[q];
+        if (out) *out = r;
+        feasible = r.cs_overhead <= search->cfg->cs_budget;
+        return feasible ? r.p99_response : TUNER_INFEASIBLE + r.cs_overhead;
+    }
+    
+    int rc = evaluate_quanta(search->cfg, search->fixed, search->fixed_n, quanta, &r);
+    if (rc != 0) {
+        /* Reported by run_quantum_tuner; steer the search away meanwhile */
+        search->failed = rc;
+        if (out) *out = (TunerResult){ TUNER_INFEASIBLE, TUNER_INFEASIBLE, TUNER_INFEASIBLE };
+        return TUNER_INFEASIBLE * 2;
+    }
+    search->evaluations++;
+    search->memo[q] = r;
+    search->memo_valid[q] = 1;
+    if (out) *out = r;
+    
+    feasible = r.cs_overhead <= search->cfg->cs_budget;
+    if (report_format == REPORT_TEXT) {
+        char level[16], overhead[16];
+        if (search->level < 0) strcpy(level, "all");
+        else snprintf(level, sizeof(level), "pri%d", search->level);
+        snprintf(overhead, sizeof(overhead), "%.2f%%", r.cs_overhead);
+        printf("  %-6s q=%-4d p99 RT %-8.3f mean RT %-8.3f CS OH %-8s %s\n",
+               level, q, r.p99_response, r.mean_response, overhead, feasible ? "" : "(over budget)");
+    } else if (report_format == REPORT_CSV) {
+        bw_printf(&report_out, "evaluation,%d,%d,%.6f,%.6f,%.6f,%d\n", search->level, q,
+                  r.p99_response, r.mean_response, r.cs_overhead, feasible);
+    }
+    return feasible ? r.p99_response : TUNER_INFEASIBLE + r.cs_overhead;
+}
+
+/* Integer golden-section search on [lo, hi]; assumes a unimodal objective */
+static int golden_section(TunerSearch* search, int lo, int hi) {
+    int a = lo, b = hi;
+    
+    while (b - a > 3) {
+        int c = b - (int)round((b - a) * GOLDEN_RATIO);
+        int d = a + (int)round((b - a) * GOLDEN_RATIO);
+        if (c >= d) d = c + 1;
+        if (tuner_objective(search, c, NULL) <= tuner_objective(search, d, NULL)) b = d;
+        else a = c;
+    }
+    
+    int best = a;
+    double best_value = tuner_objective(search, a, NULL);
+    for (int q = a + 1; q <= b; q++) {
+        double v = tuner_objective(search, q, NULL);
+        if (v < best_value) {
+            best_value = v;
+            best = q;
         }
-        
-        last_process_idx = p_idx;
     }
+    return best;
+}
+
+/* Context-switch overhead falls as the quantum grows, so the feasible
+ * region is [q_min, qmax]; binary search finds q_min */
+static int smallest_feasible_quantum(TunerSearch* search) {
+    int lo = 1, hi = search->cfg->qmax;
+    TunerResult r;
     
-    return cs_count;
+    tuner_objective(search, hi, &r);
+    if (r.cs_overhead > search->cfg->cs_budget) return -1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        tuner_objective(search, mid, &r);
+        if (r.cs_overhead <= search->cfg->cs_budget) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
 }
 
-int priority_preemptive_linux(Process processes[], int n, GanttChart* gc) {
-    double current_time = 0;
-    int completed = 0;
-    int cs_count = 0;
-    int last_process = -1;
-    
-    while (completed < n) {
-        int highest = -1;
-        int best_priority = 99999;
-        
-        for (int i = 0; i < n; i++) {
-            if (!processes[i].is_completed && processes[i].arrival_time <= current_time &&
-                processes[i].priority < best_priority) {
-                best_priority = processes[i].priority;
-                highest = i;
+int run_quantum_tuner(const TunerConfig* cfg) {
+    Process builtin[MAX_PROCESSES];
+    TunerSearch search;
+    int levels[MAX_PRIORITY_LEVELS] = { 0 };
+    
+    memset(&search, 0, sizeof(search));
+    search.cfg = cfg;
+    search.level = -1;
+    
+    if (cfg->workload.replicas == 0) {
+        search.fixed_n = init_default_workload(builtin);
+        search.fixed = builtin;
+        for (int i = 0; i < search.fixed_n; i++) levels[builtin[i].priority] = 1;
+    } else {
+        for (int i = 1; i <= cfg->workload.priority_levels && i < MAX_PRIORITY_LEVELS; i++) levels[i] = 1;
+    }
+    
+    double start = get_time_ms();
+    if (report_format == REPORT_TEXT) {
+        print_double_separator(130);
+        printf("%s%s     QUANTUM TUNER - %s, minimize p99 response time, CS overhead <= %.2f%%     %s\n",
+               COLOR_BOLD, COLOR_WHITE, cfg->prr ? "Priority RR" : "Round Robin", cfg->cs_budget, COLOR_RESET);
+        printf("%s   Workload: %s | Quantum range: 1-%dms%s\n", COLOR_CYAN,
+               search.fixed ? "TechNova scenario" : "Monte Carlo replicas", cfg->qmax, COLOR_RESET);
+        print_double_separator(130);
+    } else {
+        bw_init(&report_out, stdout);
+        if (report_format == REPORT_CSV)
+            bw_puts(&report_out, "record,level,quantum,p99_response,mean_response,cs_overhead_percent,feasible\n");
+    }
+    
+    int q_min = smallest_feasible_quantum(&search);
+    if (search.failed) {
+        fprintf(stderr, "Quantum tuner: %s\n", strerror(search.failed));
+        if (report_format != REPORT_TEXT) bw_flush(&report_out);
+        return 1;
+    }
+    if (q_min < 0) {
+        fprintf(stderr, "No quantum up to %dms meets the %.2f%% CS overhead budget\n", cfg->qmax, cfg->cs_budget);
+        if (report_format != REPORT_TEXT) bw_flush(&report_out);
+        return 1;
+    }
+    
+    int best = golden_section(&search, q_min, cfg->qmax);
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) search.quanta[i] = best;
+    
+    /* Per-priority refinement: coordinate descent, one golden-section per level.
+     * The search is not guaranteed to find the incumbent again on a
+     * non-unimodal axis, so a level only moves when that strictly improves */
+    if (cfg->prr && cfg->per_priority) {
+        for (int pass = 0; pass < 2; pass++) {
+            for (int level = 0; level < MAX_PRIORITY_LEVELS; level++) {
+                if (!levels[level]) continue;
+                search.level = level;
+                memset(search.memo_valid, 0, sizeof(search.memo_valid));
+                double incumbent = tuner_objective(&search, search.quanta[level], NULL);
+                int q = golden_section(&search, q_min, cfg->qmax);
+                if (tuner_objective(&search, q, NULL) < incumbent) search.quanta[level] = q;
             }
         }
-        
-        if (highest == -1) {
-            current_time++;
-            continue;
+        search.level = -1;
+    }
+    
+    TunerResult final;
+    if (!search.failed) search.failed = evaluate_quanta(cfg, search.fixed, search.fixed_n, search.quanta, &final);
+    if (search.failed) {
+        fprintf(stderr, "Quantum tuner: %s\n", strerror(search.failed));
+        if (report_format != REPORT_TEXT) bw_flush(&report_out);
+        return 1;
+    }
+    double elapsed = get_time_ms() - start;
+    
+    if (report_format == REPORT_TEXT) {
+        print_separator(130);
+        printf("%sBest quantum:%s ", COLOR_BOLD, COLOR_RESET);
+        if (cfg->prr && cfg->per_priority) {
+            for (int i = 0; i < MAX_PRIORITY_LEVELS; i++)
+                if (levels[i]) printf("pri%d=%dms ", i, search.quanta[i]);
+        } else {
+            printf("%dms ", best);
         }
-        
-        if (last_process != -1 && last_process != highest) {
-            current_time += CONTEXT_SWITCH_PENALTY;
-            cs_count++;
-            processes[highest].context_switches++;
+        printf("| p99 RT %s%.3f ms%s | mean RT %.3f ms | CS OH %s%.2f%%%s\n",
+               COLOR_GREEN, final.p99_response, COLOR_RESET, final.mean_response,
+               COLOR_MAGENTA, final.cs_overhead, COLOR_RESET);
+        printf("%d evaluations in %.1f ms\n", search.evaluations, elapsed);
+        print_double_separator(130);
+    } else if (report_format == REPORT_CSV) {
+        for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
+            if (!levels[i] && cfg->per_priority) continue;
+            bw_printf(&report_out, "best,%d,%d,%.6f,%.6f,%.6f,%d\n", cfg->per_priority ? i : -1,
+                      search.quanta[i], final.p99_response, final.mean_response, final.cs_overhead,
+                      final.cs_overhead <= cfg->cs_budget);
+            if (!cfg->per_priority) break;
         }
-        
-        if (processes[highest].response_time == -1) {
-            processes[highest].start_time = current_time;
-            processes[highest].response_time = current_time - processes[highest].arrival_time;
+    } else {
+        bw_printf(&report_out, "{\"policy\":\"%s\",\"cs_budget\":%.4f,\"quantum\":%d,\"quanta\":{",
+                  cfg->prr ? "prr" : "rr", cfg->cs_budget, best);
+        int first = 1;
+        for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
+            if (!levels[i] || !(cfg->prr && cfg->per_priority)) continue;
+            bw_printf(&report_out, "%s\"%d\":%d", first ? "" : ",", i, search.quanta[i]);
+            first = 0;
         }
-        
-        add_gantt_entry(gc, processes[highest].pid, current_time, current_time + 1);
-        processes[highest].remaining_time--;
-        current_time++;
-        
-        if (processes[highest].remaining_time == 0) {
-            processes[highest].completion_time = current_time;
-            processes[highest].turnaround_time = current_time - processes[highest].arrival_time;
-            processes[highest].waiting_time = processes[highest].turnaround_time - processes[highest].burst_time;
-            processes[highest].is_completed = 1;
-            completed++;
+        bw_printf(&report_out, "},\"p99_response\":%.6f,\"mean_response\":%.6f,"
+                  "\"cs_overhead_percent\":%.6f,\"evaluations\":%d}\n",
+                  final.p99_response, final.mean_response, final.cs_overhead, search.evaluations);
+    }
+    if (report_format != REPORT_TEXT) bw_flush(&report_out);
+    fflush(stdout);
+    return 0;
+}
+
+
+/* ==================================================================================
+ * CHECKPOINT / RESUME (binary engine snapshots)
+ *
+ * Layout (host byte order): magic, version, engine scalars, quanta, ready
+ * queues as process indices, processes and the Gantt timeline. Doubles are
+ * stored bit-for-bit so a resumed run reproduces an uninterrupted one.
+ * ================================================================================== */
+
+#define SNAPSHOT_MAGIC "CW11SNAP"
+#define SNAPSHOT_VERSION 2
+
+static void snap_put(FILE* fp, const void* data, size_t len, int* ok) {
+    if (*ok && fwrite(data, 1, len, fp) != len) *ok = 0;
+}
+
+static void snap_get(FILE* fp, void* data, size_t len, int* ok) {
+    if (*ok && fread(data, 1, len, fp) != len) *ok = 0;
+}
+
+static void snap_put_i32(FILE* fp, int32_t v, int* ok) { snap_put(fp, &v, sizeof(v), ok); }
+static void snap_put_f64(FILE* fp, double v, int* ok) { snap_put(fp, &v, sizeof(v), ok); }
+
+static int32_t snap_get_i32(FILE* fp, int* ok) {
+    int32_t v = 0;
+    snap_get(fp, &v, sizeof(v), ok);
+    return v;
+}
+
+static double snap_get_f64(FILE* fp, int* ok) {
+    double v = 0;
+    snap_get(fp, &v, sizeof(v), ok);
+    return v;
+}
+
+/* Strings are length-prefixed so unused buffer tails are not stored */
+static void snap_put_str(FILE* fp, const char* str, int* ok) {
+    uint8_t len = (uint8_t)strlen(str);
+    snap_put(fp, &len, 1, ok);
+    snap_put(fp, str, len, ok);
+}
+
+static void snap_get_str(FILE* fp, char* str, size_t size, int* ok) {
+    uint8_t len = 0;
+    snap_get(fp, &len, 1, ok);
+    if (len >= size) *ok = 0;
+    if (!*ok) return;
+    snap_get(fp, str, len, ok);
+    str[len] = '\0';
+}
+
+/* Writes to PATH.tmp and renames, so a crash never leaves a torn snapshot */
+int sim_save(const SimState* s, const char* path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) return -1;
+    
+    int ok = 1;
+    snap_put(fp, SNAPSHOT_MAGIC, 8, &ok);
+    snap_put_i32(fp, SNAPSHOT_VERSION, &ok);
+    snap_put_i32(fp, s->algorithm, &ok);
+    snap_put_i32(fp, s->n, &ok);
+    snap_put_f64(fp, s->current_time, &ok);
+    snap_put_i32(fp, s->completed, &ok);
+    snap_put_i32(fp, s->index, &ok);
+    snap_put_i32(fp, s->cs_count, &ok);
+    snap_put_i32(fp, s->last_process, &ok);
+    snap_put(fp, &s->steps, sizeof(s->steps), &ok);
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) snap_put_i32(fp, s->quanta[i], &ok);
+    
+    for (int q = 0; q < MAX_PRIORITY_LEVELS; q++) {
+        const Queue* queue = &s->queues[q];
+        snap_put_i32(fp, queue->size, &ok);
+        for (int k = 0; k < queue->size; k++) {
+            Process* p = queue->processes[(queue->front + k) % MAX_QUEUE_SIZE];
+            snap_put_i32(fp, (int32_t)(p - s->processes), &ok);
         }
-        
-        last_process = highest;
     }
     
-    return cs_count;
+    for (int i = 0; i < s->n; i++) {
+        const Process* p = &s->processes[i];
+        snap_put_str(fp, p->pid, &ok);
+        snap_put_str(fp, p->service_role, &ok);
+        snap_put_i32(fp, p->arrival_time, &ok);
+        snap_put_i32(fp, p->burst_time, &ok);
+        snap_put_i32(fp, p->priority, &ok);
+        snap_put_i32(fp, p->remaining_time, &ok);
+        snap_put_f64(fp, p->completion_time, &ok);
+        snap_put_f64(fp, p->turnaround_time, &ok);
+        snap_put_f64(fp, p->waiting_time, &ok);
+        snap_put_f64(fp, p->response_time, &ok);
+        snap_put_f64(fp, p->start_time, &ok);
+        snap_put_i32(fp, p->is_completed, &ok);
+        snap_put_i32(fp, p->context_switches, &ok);
+    }
+    
+    snap_put_i32(fp, s->gc->count, &ok);
+    for (int i = 0; i < s->gc->count; i++) {
+        snap_put_str(fp, s->gc->entries[i].pid, &ok);
+        snap_put_f64(fp, s->gc->entries[i].start_time, &ok);
+        snap_put_f64(fp, s->gc->entries[i].end_time, &ok);
+    }
+    
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
 }
 
-int prr_linux(Process processes[], int n, GanttChart* gc) {
-    Queue priority_queues[10];
-    for (int i = 0; i < 10; i++) init_queue(&priority_queues[i]);
-    
-    qsort(processes, n, sizeof(Process), compare_arrival);
-    double current_time = 0;
-    int completed = 0;
-    int index = 0;
-    int cs_count = 0;
-    int last_process_idx = -1;
-    
-    while (completed < n) {
-        while (index < n && processes[index].arrival_time <= current_time) {
-            enqueue(&priority_queues[processes[index].priority], &processes[index]);
-            index++;
-        }
-        
-        int highest_priority = -1;
-        for (int i = 0; i < 10; i++) {
-            if (!is_queue_empty(&priority_queues[i])) {
-                highest_priority = i;
-                break;
-            }
-        }
-        
-        if (highest_priority == -1) {
-            if (index < n) current_time = processes[index].arrival_time;
-            continue;
-        }
-        
-        Process* p = dequeue(&priority_queues[highest_priority]);
-        int p_idx = p - processes;
-        
-        if (last_process_idx != -1 && last_process_idx != p_idx) {
-            current_time += CONTEXT_SWITCH_PENALTY;
-            cs_count++;
-            p->context_switches++;
+int sim_load(SimState* s, const char* path, Process processes[], GanttChart* gc) {
+    FILE* fp = fopen(path, "rb");
+    int done = 0;
+    if (!fp) return -1;
+    
+    int ok = 1;
+    char magic[8];
+    snap_get(fp, magic, 8, &ok);
+    if (!ok || memcmp(magic, SNAPSHOT_MAGIC, 8) != 0 || snap_get_i32(fp, &ok) != SNAPSHOT_VERSION) {
+        fclose(fp);
+        return -1;
+    }
+    
+    s->processes = processes;
+    s->gc = gc;
+    s->algorithm = snap_get_i32(fp, &ok);
+    s->n = snap_get_i32(fp, &ok);
+    if (s->algorithm < 0 || s->algorithm >= MAX_ALGORITHMS || s->n < 0 || s->n > MAX_PROCESSES) ok = 0;
+    s->current_time = snap_get_f64(fp, &ok);
+    s->completed = snap_get_i32(fp, &ok);
+    s->index = snap_get_i32(fp, &ok);
+    s->cs_count = snap_get_i32(fp, &ok);
+    s->last_process = snap_get_i32(fp, &ok);
+    snap_get(fp, &s->steps, sizeof(s->steps), &ok);
+    for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
+        s->quanta[i] = snap_get_i32(fp, &ok);
+        if (s->quanta[i] < 1) ok = 0;
+    }
+    /* The step functions index processes[] with these and divide time by quanta */
+    if (s->completed < 0 || s->completed > s->n || s->index < 0 || s->index > s->n ||
+        s->last_process < -1 || s->last_process >= s->n) ok = 0;
+    
+    for (int q = 0; q < MAX_PRIORITY_LEVELS && ok; q++) {
+        init_queue(&s->queues[q]);
+        int size = snap_get_i32(fp, &ok);
+        if (size < 0 || size > MAX_QUEUE_SIZE) ok = 0;
+        for (int k = 0; k < size && ok; k++) {
+            int idx = snap_get_i32(fp, &ok);
+            if (idx < 0 || idx >= s->n) ok = 0;
+            else enqueue(&s->queues[q], &processes[idx]);
         }
-        
-        if (p->response_time == -1) {
-            p->start_time = current_time;
-            p->response_time = current_time - p->arrival_time;
+    }
+    
+    for (int i = 0; i < s->n && ok; i++) {
+        Process* p = &processes[i];
+        snap_get_str(fp, p->pid, sizeof(p->pid), &ok);
+        snap_get_str(fp, p->service_role, sizeof(p->service_role), &ok);
+        p->arrival_time = snap_get_i32(fp, &ok);
+        p->burst_time = snap_get_i32(fp, &ok);
+        p->priority = snap_get_i32(fp, &ok);
+        p->remaining_time = snap_get_i32(fp, &ok);
+        p->completion_time = snap_get_f64(fp, &ok);
+        p->turnaround_time = snap_get_f64(fp, &ok);
+        p->waiting_time = snap_get_f64(fp, &ok);
+        p->response_time = snap_get_f64(fp, &ok);
+        p->start_time = snap_get_f64(fp, &ok);
+        p->is_completed = snap_get_i32(fp, &ok);
+        p->context_switches = snap_get_i32(fp, &ok);
+        if (p->priority < 0 || p->priority >= MAX_PRIORITY_LEVELS) ok = 0;
+        /* A pending process with no time left, or a finished one with some,
+         * never completes and the run would not end */
+        if (p->is_completed == 0 && (p->remaining_time < 1 || p->remaining_time > p->burst_time)) ok = 0;
+        if (p->is_completed == 1 && p->remaining_time != 0) ok = 0;
+        if (p->is_completed != 0 && p->is_completed != 1) ok = 0;
+        done += p->is_completed == 1;
+    }
+    if (ok && (done != s->completed || !isfinite(s->current_time) || s->current_time < 0)) ok = 0;
+    
+    init_gantt(gc);
+    int count = snap_get_i32(fp, &ok);
+    if (count < 0 || count > MAX_GANTT_ENTRIES) ok = 0;
+    for (int i = 0; i < count && ok; i++) {
+        snap_get_str(fp, gc->entries[i].pid, sizeof(gc->entries[i].pid), &ok);
+        gc->entries[i].start_time = snap_get_f64(fp, &ok);
+        gc->entries[i].end_time = snap_get_f64(fp, &ok);
+    }
+    if (ok) gc->count = count;
+    
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+/* Single-algorithm run that can stop, checkpoint and resume between steps */
+/* Report label for a checkpointed run: the table name with its "q=2ms" replaced
+ * by the quanta actually in force, one per level where they differ */
+static void checkpoint_label(const SimState* s, char* label, size_t size) {
+    const char* name = algorithms[s->algorithm].name;
+    const char* q = strstr(name, "q=");
+    if (algorithms[s->algorithm].step != round_robin_step || !q) {
+        snprintf(label, size, "%s", name);
+        return;
+    }
+    
+    int uniform = 1;
+    for (int i = 1; i < MAX_PRIORITY_LEVELS; i++) uniform &= s->quanta[i] == s->quanta[0];
+    
+    int len = snprintf(label, size, "%.*sq=", (int)(q - name), name);
+    for (int i = 0; i < (uniform ? 1 : MAX_PRIORITY_LEVELS) && len < (int)size; i++)
+        len += snprintf(label + len, size - len, "%s%d", i ? "/" : "", s->quanta[i]);
+    if (len < (int)size) snprintf(label + len, size - len, "%s", strchr(q, 'm'));
+}
+
+int run_checkpointed(const CheckpointConfig* cfg, Process workload[], int n) {
+    Process procs[MAX_PROCESSES];
+    char label[64];
+    GanttChart* gc = malloc(sizeof(GanttChart));
+    SimState s;
+    if (!gc) return 1;
+    
+    if (cfg->resume_path) {
+        if (sim_load(&s, cfg->resume_path, procs, gc) != 0) {
+            fprintf(stderr, "%s: not a valid cw11 snapshot\n", cfg->resume_path);
+            free(gc);
+            return 1;
         }
-        
-        int exec_time = (TIME_QUANTUM < p->remaining_time) ? TIME_QUANTUM : p->remaining_time;
-        add_gantt_entry(gc, p->pid, current_time, current_time + exec_time);
-        p->remaining_time -= exec_time;
-        current_time += exec_time;
-        
-        while (index < n && processes[index].arrival_time <= current_time) {
-            enqueue(&priority_queues[processes[index].priority], &processes[index]);
-            index++;
+    } else {
+        copy_processes(workload, procs, n);
+        init_gantt(gc);
+        sim_init(&s, cfg->algorithm, procs, n, gc, NULL);
+    }
+    
+    if (cfg->algorithm >= 0 && cfg->algorithm != s.algorithm) {
+        fprintf(stderr, "%s: snapshot is a %s run, not --algo %s\n", cfg->resume_path,
+                algorithms[s.algorithm].key, algorithms[cfg->algorithm].key);
+        free(gc);
+        return 1;
+    }
+    if (cfg->quantum != 0 && algorithms[s.algorithm].step != round_robin_step) {
+        fprintf(stderr, "--quantum only applies to rr and prr, not %s\n", algorithms[s.algorithm].key);
+        free(gc);
+        return 1;
+    }
+    
+    /* What-if fork: a new quantum applies from the snapshot point onwards */
+    if (cfg->quantum > 0) {
+        for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) s.quanta[i] = cfg->quantum;
+    }
+    
+    SimStepFn step = algorithms[s.algorithm].step;
+    double start_time = get_time_ms();
+    while (step(&s)) {
+        s.steps++;
+        if (cfg->path && cfg->every > 0 && s.steps % cfg->every == 0 && sim_save(&s, cfg->path) != 0) {
+            perror(cfg->path);
+            free(gc);
+            return 1;
         }
-        
-        if (p->remaining_time > 0) {
-            enqueue(&priority_queues[p->priority], p);
-        } else {
-            p->completion_time = current_time;
-            p->turnaround_time = current_time - p->arrival_time;
-            p->waiting_time = p->turnaround_time - p->burst_time;
-            completed++;
+        if (cfg->stop_after > 0 && s.steps >= cfg->stop_after) {
+            const char* path = cfg->path ? cfg->path : "cw11.snap";
+            if (sim_save(&s, path) != 0) {
+                perror(path);
+                free(gc);
+                return 1;
+            }
+            fprintf(stderr, "Stopped after %ld steps at t=%.2fms; snapshot in %s\n",
+                    s.steps, s.current_time, path);
+            free(gc);
+            return 0;
         }
-        
-        last_process_idx = p_idx;
     }
+    double end_time = get_time_ms();
     
-    return cs_count;
+    checkpoint_label(&s, label, sizeof(label));
+    report_begin();
+    report_run(label, procs, s.n, s.cs_count, end_time - start_time, gc);
+    report_end();
+    free(gc);
+    return 0;
 }
@@ -1,70 +1,985 @@
+/* Build: gcc -O2 ipc.c -o ipc */
+
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/msg.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/futex.h>
+#include <mqueue.h>
+#include <stddef.h>
 #include <fcntl.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "perf_counters.h"
+
+#define SIZE 64                 /* Default message size, bytes */
+#define ITERATIONS 10000        /* Round trips, and messages per stream */
+#define WARMUP 100
+#define MIN_ITERS 4             /* Sweep: fewest round trips at the largest sizes */
+#define BYTES_BUDGET (256L << 20)   /* Sweep: bytes per phase that set iterations per size */
+#define SWEEP_MIN 8
+#define SWEEP_MAX (64L << 20)
+#define MAX_SIZES 64
+#define CACHE_LINE 64
+#define SPIN_LIMIT 1024         /* Spins before a waiter sleeps on its futex */
+#define RING_BYTES (1 << 20)    /* Per-direction shm ring */
+#define SHM_NAME "/ipc_bench"
+#define DGRAM_CHUNK (64 * 1024)     /* unix-dgram / seqpacket: bytes per datagram */
+#define UDP_CHUNK 8192              /* udp: bytes per datagram, below the loopback MTU */
+#define UDP_BUFFER (4 << 20)        /* udp: requested receive buffer */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* A bidirectional channel between a parent (side 0) and a forked child
+ * (side 1). Side s sends on direction s and receives on direction 1 - s;
+ * send() and recv() move exactly len bytes, however the transport frames them */
+typedef struct {
+    const char* name;
+    int (*setup)(void);                 /* Before fork */
+    void (*attach)(int side);           /* After fork: drop the other side's ends */
+    int (*send)(int side, const void* buf, size_t len);
+    int (*recv)(int side, void* buf, size_t len);
+    void (*teardown)(int side);
+    size_t (*capacity)(void);           /* After setup: bytes the channel buffers, 0 = unknown */
+} Transport;
+
+typedef struct {
+    double one_way_p50, one_way_p99;    /* ns, both directions pooled */
+    double rtt_p50, rtt_p99;
+    double bytes_per_sec;               /* Child-to-parent stream */
+    double msgs_per_sec;
+    size_t capacity;
+} IpcResult;
+
+int perf_enabled = 0;
+int spin_limit = SPIN_LIMIT;    /* 1 on a single CPU: the peer cannot run while we spin */
+PerfCounters perf;
+PerfSample perf_start, perf_region;
+
+/* Brackets a measured region with counter reads when --perf is given. The
+ * counters are inherited by the forked child and folded in when it is reaped;
+ * getrusage adds the reaped child to the parent */
+static void region_rusage(PerfSample* s) {
+    PerfSample children;
+    perf_rusage(s, RUSAGE_SELF);
+    perf_rusage(&children, RUSAGE_CHILDREN);
+    s->voluntary += children.voluntary;
+    s->involuntary += children.involuntary;
+}
+
+void region_begin() {
+    if (!perf_enabled) return;
+    perf_read(&perf, &perf_start);
+    region_rusage(&perf_start);
+}
+
+void region_end() {
+    PerfSample end;
+    if (!perf_enabled) return;
+    perf_read(&perf, &end);
+    region_rusage(&end);
+    perf_delta(&perf_region, &perf_start, &end);
+}
 
-#define SIZE 4096
-#define ITERATIONS 10000
+void region_report(long ops) {
+    if (!perf_enabled) return;
+    printf("  %-20s", "");
+    perf_print_row(stdout, &perf_region, ops);
+    printf("\n");
+}
 
-double get_time_ms() {
+static inline uint64_t monotonic_ns(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
-void test_shared_memory() {
-    const char *name = "/ipc_test";
-    int shm_fd = shm_open(name, O_CREAT | O_RDWR, 0666);
-    ftruncate(shm_fd, SIZE);
+/* ==================================================================================
+ * POSIX SHARED MEMORY (one SPSC byte ring per direction; waiters spin, then
+ * sleep on a process-shared futex)
+ * ================================================================================== */
+
+/* Eventcount: a sleeper publishes itself in waiters, re-checks its condition
+ * and sleeps on seq; a notifier that sees waiters bumps seq and wakes it.
+ * With efd >= 0 the sleep is a read() on that eventfd instead of a futex */
+typedef struct {
+    atomic_uint seq;
+    atomic_int waiters;
+    int efd;
+} EventCount;
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_ulong head;     /* Bytes written, ever */
+    EventCount data;                            /* Reader sleeps here */
+    _Alignas(CACHE_LINE) atomic_ulong tail;     /* Bytes read, ever */
+    EventCount space;                           /* Writer sleeps here */
+    _Alignas(CACHE_LINE) char buf[RING_BYTES];
+} ShmRing;
 
-    char *ptr = mmap(0, SIZE, PROT_WRITE, MAP_SHARED, shm_fd, 0);
+ShmRing* shm_rings;             /* [2], one per direction */
 
-    double start = get_time_ms();
+static void futex_call(atomic_uint* addr, int op, unsigned val) {
+    syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
 
-    for(int i=0;i<ITERATIONS;i++) {
-        strcpy(ptr, "Hello IPC");
+static void ec_notify(EventCount* ec) {
+    if (atomic_load(&ec->waiters)) {
+        atomic_store(&ec->waiters, 0);
+        atomic_fetch_add(&ec->seq, 1);
+        if (ec->efd >= 0) {
+            uint64_t one = 1;
+            if (write(ec->efd, &one, sizeof(one)) < 0) perror("eventfd write");
+        } else {
+            futex_call(&ec->seq, FUTEX_WAKE, INT_MAX);
+        }
     }
+}
 
-    double end = get_time_ms();
+/* Returns once *word no longer equals old */
+static void ec_wait(EventCount* ec, atomic_ulong* word, unsigned long old) {
+    int spins = 0;
+    while (atomic_load(word) == old) {
+        if (++spins < spin_limit) {
+            cpu_relax();
+            continue;
+        }
+        unsigned seq = atomic_load(&ec->seq);
+        atomic_store(&ec->waiters, 1);
+        if (atomic_load(word) != old) break;
+        if (ec->efd >= 0) {
+            /* A stale count from an earlier wake only costs one extra pass */
+            uint64_t count;
+            if (read(ec->efd, &count, sizeof(count)) < 0 && errno != EINTR) perror("eventfd read");
+        } else {
+            futex_call(&ec->seq, FUTEX_WAIT, seq);
+        }
+        spins = 0;
+    }
+}
 
-    printf("Shared Memory Time: %.4f ms\n", end - start);
+/* Maps both rings. The name is unlinked straight away: the child inherits
+ * the mapping, and nothing is left behind in /dev/shm on a crash */
+static int shm_setup(void) {
+    int fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return -1;
+    }
+    shm_unlink(SHM_NAME);
+    if (ftruncate(fd, 2 * sizeof(ShmRing)) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+    shm_rings = mmap(NULL, 2 * sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm_rings == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    for (int d = 0; d < 2; d++) shm_rings[d].data.efd = shm_rings[d].space.efd = -1;
+    return 0;
+}
 
-    munmap(ptr, SIZE);
-    close(shm_fd);
-    shm_unlink(name);
+static void shm_teardown(int side);
+
+/* The same rings, but sleepers block in read() on an eventfd per eventcount */
+static int eventfd_setup(void) {
+    if (shm_setup() != 0) return -1;
+    for (int d = 0; d < 2; d++) {
+        shm_rings[d].data.efd = eventfd(0, 0);
+        shm_rings[d].space.efd = eventfd(0, 0);
+        if (shm_rings[d].data.efd < 0 || shm_rings[d].space.efd < 0) {
+            perror("eventfd");
+            shm_teardown(0);
+            return -1;
+        }
+    }
+    return 0;
 }
 
-void test_pipe() {
-    int fd[2];
-    pipe(fd);
+static void shm_attach(int side) { (void)side; }
 
-    char buffer[SIZE] = "Hello IPC";
+static int shm_send(int side, const void* buf, size_t len) {
+    ShmRing* r = &shm_rings[side];
+    const char* src = buf;
+    while (len > 0) {
+        unsigned long head = atomic_load_explicit(&r->head, memory_order_relaxed);
+        unsigned long tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        size_t room = RING_BYTES - (head - tail);
+        if (room == 0) {
+            ec_wait(&r->space, &r->tail, tail);
+            continue;
+        }
+        size_t offset = head % RING_BYTES, n = len;
+        if (n > room) n = room;
+        if (n > RING_BYTES - offset) n = RING_BYTES - offset;
+        memcpy(r->buf + offset, src, n);
+        atomic_store(&r->head, head + n);
+        ec_notify(&r->data);
+        src += n;
+        len -= n;
+    }
+    return 0;
+}
 
-    double start = get_time_ms();
+static int shm_recv(int side, void* buf, size_t len) {
+    ShmRing* r = &shm_rings[1 - side];
+    char* dst = buf;
+    while (len > 0) {
+        unsigned long tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        unsigned long head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head == tail) {
+            ec_wait(&r->data, &r->head, head);
+            continue;
+        }
+        size_t offset = tail % RING_BYTES, n = len;
+        if (n > head - tail) n = head - tail;
+        if (n > RING_BYTES - offset) n = RING_BYTES - offset;
+        memcpy(dst, r->buf + offset, n);
+        atomic_store(&r->tail, tail + n);
+        ec_notify(&r->space);
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
 
-    for(int i=0;i<ITERATIONS;i++) {
-        write(fd[1], buffer, strlen(buffer)+1);
-        read(fd[0], buffer, SIZE);
+static void shm_teardown(int side) {
+    (void)side;
+    for (int d = 0; d < 2; d++) {
+        if (shm_rings[d].data.efd >= 0) close(shm_rings[d].data.efd);
+        if (shm_rings[d].space.efd >= 0) close(shm_rings[d].space.efd);
     }
+    munmap(shm_rings, 2 * sizeof(ShmRing));
+}
+
+static size_t shm_capacity(void) { return RING_BYTES; }
 
-    double end = get_time_ms();
+/* ==================================================================================
+ * FILE-DESCRIPTOR TRANSPORTS (side s writes tx_fd[s] and reads rx_fd[s]; a
+ * pipe pair has four ends, a connected socket pair one end per side)
+ * ================================================================================== */
 
-    printf("Pipe Time: %.4f ms\n", end - start);
+int tx_fd[2] = { -1, -1 }, rx_fd[2] = { -1, -1 };
 
-    close(fd[0]);
-    close(fd[1]);
+static int pipe_setup(void) {
+    int p0[2], p1[2];
+    if (pipe(p0) != 0 || pipe(p1) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    tx_fd[0] = p0[1];
+    rx_fd[1] = p0[0];
+    tx_fd[1] = p1[1];
+    rx_fd[0] = p1[0];
+    return 0;
+}
+
+static void fd_attach(int side) {
+    int other = 1 - side;
+    if (tx_fd[other] != tx_fd[side] && tx_fd[other] != rx_fd[side]) close(tx_fd[other]);
+    if (rx_fd[other] != tx_fd[other] && rx_fd[other] != rx_fd[side]) close(rx_fd[other]);
 }
 
-int main() {
+static void fd_teardown(int side) {
+    close(tx_fd[side]);
+    if (rx_fd[side] != tx_fd[side]) close(rx_fd[side]);
+}
 
-    printf("Linux IPC Benchmark\n");
+static int stream_send(int side, const void* buf, size_t len) {
+    const char* src = buf;
+    while (len > 0) {
+        ssize_t n = write(tx_fd[side], src, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        src += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int stream_recv(int side, void* buf, size_t len) {
+    char* dst = buf;
+    while (len > 0) {
+        ssize_t n = read(rx_fd[side], dst, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
 
-    test_shared_memory();
-    test_pipe();
+static size_t pipe_capacity(void) {
+    int bytes = fcntl(tx_fd[0], F_GETPIPE_SZ);
+    return bytes > 0 ? (size_t)bytes : 0;
+}
+
+static void sock_pair(int a, int b) {
+    tx_fd[0] = rx_fd[0] = a;
+    tx_fd[1] = rx_fd[1] = b;
+}
+
+/* Send buffer as the kernel reports it (it doubles the requested value for bookkeeping) */
+static size_t sock_capacity(void) {
+    int bytes = 0;
+    socklen_t len = sizeof(bytes);
+    if (getsockopt(tx_fd[0], SOL_SOCKET, SO_SNDBUF, &bytes, &len) != 0 || bytes <= 0) return 0;
+    return (size_t)bytes;
+}
+
+static int socketpair_setup(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        perror("socketpair");
+        return -1;
+    }
+    sock_pair(sv[0], sv[1]);
+    return 0;
+}
+
+/* Abstract-namespace address, so nothing appears in the filesystem */
+static socklen_t unix_address(struct sockaddr_un* addr, int index) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    int n = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1, "ipc_bench.%d.%d", (int)getpid(), index);
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + n);
+}
+
+/* listen / connect / accept for a connection-oriented socket type; the
+ * accepted end is the parent's */
+static int connect_pair(int domain, int type, const struct sockaddr* addr, socklen_t addr_len) {
+    int listener = socket(domain, type, 0), client = -1, server = -1;
+    struct sockaddr_storage bound;
+    socklen_t bound_len = sizeof(bound);
+
+    if (listener < 0 || bind(listener, addr, addr_len) != 0 || listen(listener, 1) != 0 ||
+        getsockname(listener, (struct sockaddr*)&bound, &bound_len) != 0) goto fail;
+    if ((client = socket(domain, type, 0)) < 0 || connect(client, (struct sockaddr*)&bound, bound_len) != 0) goto fail;
+    if ((server = accept(listener, NULL, NULL)) < 0) goto fail;
+    close(listener);
+    sock_pair(server, client);
+    return 0;
+
+fail:
+    perror("socket");
+    if (listener >= 0) close(listener);
+    if (client >= 0) close(client);
+    return -1;
+}
+
+static int unix_stream_setup(void) {
+    struct sockaddr_un addr;
+    socklen_t len = unix_address(&addr, 0);
+    return connect_pair(AF_UNIX, SOCK_STREAM, (struct sockaddr*)&addr, len);
+}
+
+static int unix_seqpacket_setup(void) {
+    struct sockaddr_un addr;
+    socklen_t len = unix_address(&addr, 0);
+    return connect_pair(AF_UNIX, SOCK_SEQPACKET, (struct sockaddr*)&addr, len);
+}
+
+/* Nagle would hold back every small message waiting for an ACK */
+static int tcp_setup(void) {
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = 0 };
+    int one = 1;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect_pair(AF_INET, SOCK_STREAM, (struct sockaddr*)&addr, sizeof(addr)) != 0) return -1;
+    setsockopt(tx_fd[0], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(tx_fd[1], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return 0;
+}
+
+/* ==================================================================================
+ * DATAGRAM TRANSPORTS (messages larger than one datagram go out in chunks;
+ * every chunk must arrive whole)
+ * ================================================================================== */
+
+size_t dgram_chunk;
+size_t flow_budget;             /* UDP only: bytes in flight before the receiver acks */
+size_t flow_used[2];            /* Per direction, mirrored by sender and receiver */
+
+/* UDP drops datagrams once the receive buffer is full, so the sender stops
+ * after flow_budget bytes (payload plus a per-datagram allowance) until the
+ * receiver, counting the same chunks, sends a one-byte ack */
+static int flow_account(int side, int direction, size_t chunk, int sending) {
+    char ack = 0;
+    if (!flow_budget) return 0;
+    flow_used[direction] += chunk + 1024;
+    if (flow_used[direction] < flow_budget) return 0;
+    flow_used[direction] = 0;
+    if (sending) return recv(rx_fd[side], &ack, 1, 0) == 1 ? 0 : -1;
+    return send(tx_fd[side], &ack, 1, 0) == 1 ? 0 : -1;
+}
+
+static int dgram_send(int side, const void* buf, size_t len) {
+    const char* src = buf;
+    while (len > 0) {
+        size_t n = len < dgram_chunk ? len : dgram_chunk;
+        ssize_t sent = send(tx_fd[side], src, n, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent != (ssize_t)n || flow_account(side, side, n, 1) != 0) return -1;
+        src += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int dgram_recv(int side, void* buf, size_t len) {
+    char* dst = buf;
+    while (len > 0) {
+        size_t n = len < dgram_chunk ? len : dgram_chunk;
+        ssize_t got = recv(rx_fd[side], dst, n, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got != (ssize_t)n || flow_account(side, 1 - side, n, 0) != 0) return -1;
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int unix_seqpacket_dgram_setup(void) {
+    dgram_chunk = DGRAM_CHUNK;
+    flow_budget = 0;
+    return unix_seqpacket_setup();
+}
+
+static int unix_dgram_setup(void) {
+    struct sockaddr_un addr[2];
+    socklen_t len[2];
+    int fd[2] = { socket(AF_UNIX, SOCK_DGRAM, 0), socket(AF_UNIX, SOCK_DGRAM, 0) };
+
+    dgram_chunk = DGRAM_CHUNK;
+    flow_budget = 0;
+    for (int i = 0; i < 2; i++) len[i] = unix_address(&addr[i], i + 1);
+    if (fd[0] < 0 || fd[1] < 0 ||
+        bind(fd[0], (struct sockaddr*)&addr[0], len[0]) != 0 || bind(fd[1], (struct sockaddr*)&addr[1], len[1]) != 0 ||
+        connect(fd[0], (struct sockaddr*)&addr[1], len[1]) != 0 || connect(fd[1], (struct sockaddr*)&addr[0], len[0]) != 0) {
+        perror("unix dgram");
+        if (fd[0] >= 0) close(fd[0]);
+        if (fd[1] >= 0) close(fd[1]);
+        return -1;
+    }
+    sock_pair(fd[0], fd[1]);
+    return 0;
+}
+
+/* A lost datagram would otherwise hang the pair: time out and report failure */
+static int udp_setup(void) {
+    struct sockaddr_in addr[2];
+    socklen_t len = sizeof(addr[0]);
+    int fd[2] = { socket(AF_INET, SOCK_DGRAM, 0), socket(AF_INET, SOCK_DGRAM, 0) };
+    int rcvbuf = UDP_BUFFER, actual = 0;
+    socklen_t actual_len = sizeof(actual);
+    struct timeval timeout = { 2, 0 };
+
+    dgram_chunk = UDP_CHUNK;
+    flow_used[0] = flow_used[1] = 0;
+    for (int i = 0; i < 2; i++) {
+        memset(&addr[i], 0, sizeof(addr[i]));
+        addr[i].sin_family = AF_INET;
+        addr[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd[i] < 0 || bind(fd[i], (struct sockaddr*)&addr[i], len) != 0 ||
+            getsockname(fd[i], (struct sockaddr*)&addr[i], &len) != 0) goto fail;
+        /* SO_RCVBUFFORCE passes rmem_max when privileged; otherwise take what is allowed */
+        if (setsockopt(fd[i], SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0)
+            setsockopt(fd[i], SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        setsockopt(fd[i], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+    if (connect(fd[0], (struct sockaddr*)&addr[1], len) != 0 || connect(fd[1], (struct sockaddr*)&addr[0], len) != 0)
+        goto fail;
+    getsockopt(fd[0], SOL_SOCKET, SO_RCVBUF, &actual, &actual_len);
+    flow_budget = actual > 0 ? (size_t)actual / 4 : UDP_CHUNK + 1024;
+    sock_pair(fd[0], fd[1]);
+    return 0;
+
+fail:
+    perror("udp");
+    if (fd[0] >= 0) close(fd[0]);
+    if (fd[1] >= 0) close(fd[1]);
+    return -1;
+}
+
+/* ==================================================================================
+ * MESSAGE QUEUES (POSIX mqueue and SysV msg, one queue per direction; each
+ * chunk is limited to the kernel's maximum message size)
+ * ================================================================================== */
+
+mqd_t mq[2] = { (mqd_t)-1, (mqd_t)-1 };
+size_t mq_chunk;
+long mq_depth;
+
+static long read_proc_long(const char* path, long fallback) {
+    FILE* fp = fopen(path, "r");
+    long value = fallback;
+    if (!fp) return fallback;
+    if (fscanf(fp, "%ld", &value) != 1) value = fallback;
+    fclose(fp);
+    return value;
+}
+
+/* The names are unlinked once open; the child inherits the descriptors */
+static int posix_mq_setup(void) {
+    struct mq_attr attr = { 0 };
+    mq_chunk = (size_t)read_proc_long("/proc/sys/fs/mqueue/msgsize_max", 8192);
+    mq_depth = read_proc_long("/proc/sys/fs/mqueue/msg_max", 10);
+    attr.mq_maxmsg = mq_depth;
+    attr.mq_msgsize = (long)mq_chunk;
+
+    for (int i = 0; i < 2; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "/ipc_bench.%d.%d", (int)getpid(), i);
+        mq[i] = mq_open(name, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+        if (mq[i] == (mqd_t)-1) {
+            perror("mq_open");
+            if (i == 1) mq_close(mq[0]);
+            return -1;
+        }
+        mq_unlink(name);
+    }
+    return 0;
+}
+
+static void posix_mq_attach(int side) { (void)side; }
+
+static int posix_mq_send(int side, const void* buf, size_t len) {
+    const char* src = buf;
+    while (len > 0) {
+        size_t n = len < mq_chunk ? len : mq_chunk;
+        if (mq_send(mq[side], src, n, 0) != 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        src += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int posix_mq_recv(int side, void* buf, size_t len) {
+    static char* bounce;            /* mq_receive wants room for a full-size message */
+    char* dst = buf;
+    if (!bounce && !(bounce = malloc(mq_chunk))) return -1;
+    while (len > 0) {
+        size_t n = len < mq_chunk ? len : mq_chunk;
+        char* into = n == mq_chunk ? dst : bounce;
+        ssize_t got = mq_receive(mq[1 - side], into, mq_chunk, NULL);
+        if (got < 0 && errno == EINTR) continue;
+        if (got != (ssize_t)n) return -1;
+        if (into != dst) memcpy(dst, bounce, n);
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void posix_mq_teardown(int side) {
+    (void)side;
+    mq_close(mq[0]);
+    mq_close(mq[1]);
+}
+
+static size_t posix_mq_capacity(void) { return (size_t)mq_depth * mq_chunk; }
+
+int msg_queue[2] = { -1, -1 };
+size_t msg_chunk;
+
+typedef struct {
+    long mtype;
+    char mtext[];
+} SysvMsg;
+
+static int sysv_msg_setup(void) {
+    msg_chunk = (size_t)read_proc_long("/proc/sys/kernel/msgmax", 8192);
+    for (int i = 0; i < 2; i++) {
+        msg_queue[i] = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+        if (msg_queue[i] < 0) {
+            perror("msgget");
+            if (i == 1) msgctl(msg_queue[0], IPC_RMID, NULL);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int sysv_msg_send(int side, const void* buf, size_t len) {
+    static SysvMsg* msg;
+    const char* src = buf;
+    if (!msg && !(msg = malloc(sizeof(SysvMsg) + msg_chunk))) return -1;
+    msg->mtype = 1;
+    while (len > 0) {
+        size_t n = len < msg_chunk ? len : msg_chunk;
+        memcpy(msg->mtext, src, n);
+        if (msgsnd(msg_queue[side], msg, n, 0) != 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        src += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int sysv_msg_recv(int side, void* buf, size_t len) {
+    static SysvMsg* msg;
+    char* dst = buf;
+    if (!msg && !(msg = malloc(sizeof(SysvMsg) + msg_chunk))) return -1;
+    while (len > 0) {
+        size_t n = len < msg_chunk ? len : msg_chunk;
+        ssize_t got = msgrcv(msg_queue[1 - side], msg, msg_chunk, 0, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got != (ssize_t)n) return -1;
+        memcpy(dst, msg->mtext, n);
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* The parent removes the queues; it tears down only after the child's last send */
+static void sysv_msg_teardown(int side) {
+    if (side != 0) return;
+    msgctl(msg_queue[0], IPC_RMID, NULL);
+    msgctl(msg_queue[1], IPC_RMID, NULL);
+}
+
+static size_t sysv_msg_capacity(void) {
+    struct msqid_ds ds;
+    if (msgctl(msg_queue[0], IPC_STAT, &ds) != 0) return 0;
+    return (size_t)ds.msg_qbytes;
+}
+
+static const Transport transports[] = {
+    { "shm",            shm_setup,                  shm_attach,      shm_send,      shm_recv,      shm_teardown,      shm_capacity },
+    { "eventfd",        eventfd_setup,              shm_attach,      shm_send,      shm_recv,      shm_teardown,      shm_capacity },
+    { "pipe",           pipe_setup,                 fd_attach,       stream_send,   stream_recv,   fd_teardown,       pipe_capacity },
+    { "socketpair",     socketpair_setup,           fd_attach,       stream_send,   stream_recv,   fd_teardown,       sock_capacity },
+    { "unix-stream",    unix_stream_setup,          fd_attach,       stream_send,   stream_recv,   fd_teardown,       sock_capacity },
+    { "unix-dgram",     unix_dgram_setup,           fd_attach,       dgram_send,    dgram_recv,    fd_teardown,       sock_capacity },
+    { "unix-seqpacket", unix_seqpacket_dgram_setup, fd_attach,       dgram_send,    dgram_recv,    fd_teardown,       sock_capacity },
+    { "tcp",            tcp_setup,                  fd_attach,       stream_send,   stream_recv,   fd_teardown,       sock_capacity },
+    { "udp",            udp_setup,                  fd_attach,       dgram_send,    dgram_recv,    fd_teardown,       sock_capacity },
+    { "posix-mq",       posix_mq_setup,             posix_mq_attach, posix_mq_send, posix_mq_recv, posix_mq_teardown, posix_mq_capacity },
+    { "sysv-msg",       sysv_msg_setup,             posix_mq_attach, sysv_msg_send, sysv_msg_recv, sysv_msg_teardown, sysv_msg_capacity },
+};
+
+#define NUM_TRANSPORTS (int)(sizeof(transports) / sizeof(transports[0]))
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+/* Both processes follow the same script, so no control messages are needed:
+ * warmup + iters round trips, each leg stamped with the sender's clock
+ * (CLOCK_MONOTONIC is system-wide), then the child streams iters messages to
+ * the parent after a start message. The child leaves its one-way samples in
+ * shared memory for the parent */
+static void child_run(const Transport* t, char* buf, size_t size, int iters, int warmup, double* one_way) {
+    uint64_t stamp;
+    for (int i = -warmup; i < iters; i++) {
+        if (t->recv(1, buf, size) != 0) _exit(1);
+        uint64_t now = monotonic_ns();
+        memcpy(&stamp, buf, sizeof(stamp));
+        if (i >= 0) one_way[i] = (double)(now - stamp);
+        now = monotonic_ns();
+        memcpy(buf, &now, sizeof(now));
+        if (t->send(1, buf, size) != 0) _exit(1);
+    }
+
+    if (t->recv(1, buf, size) != 0) _exit(1);
+    for (int i = 0; i < iters; i++)
+        if (t->send(1, buf, size) != 0) _exit(1);
+    t->teardown(1);
+    _exit(0);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(double v[], int n, double pct) {
+    int rank = (int)(pct / 100.0 * n + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return v[rank - 1];
+}
+
+/* Runs the script against a forked child; returns -1 if the transport failed */
+int run_transport(const Transport* t, size_t size, int iters, int warmup, IpcResult* r) {
+    char* buf = malloc(size);
+    double* one_way = mmap(NULL, 2 * iters * sizeof(double), PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    double* rtt = malloc(iters * sizeof(double));
+    int rc = -1, status = 0;
+    uint64_t stamp;
+
+    if (!buf || !rtt || one_way == MAP_FAILED) goto out;
+    memset(buf, 0x5a, size);
+    if (t->setup() != 0) goto out;
+    r->capacity = t->capacity();
+
+    region_begin();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        t->attach(0);
+        t->teardown(0);
+        goto out;
+    }
+    if (pid == 0) {
+        t->attach(1);
+        child_run(t, buf, size, iters, warmup, one_way);
+    }
+    t->attach(0);
+
+    for (int i = -warmup; i < iters; i++) {
+        uint64_t start = monotonic_ns();
+        memcpy(buf, &start, sizeof(start));
+        if (t->send(0, buf, size) != 0 || t->recv(0, buf, size) != 0) goto fail;
+        uint64_t now = monotonic_ns();
+        memcpy(&stamp, buf, sizeof(stamp));
+        if (i < 0) continue;
+        one_way[iters + i] = (double)(now - stamp);
+        rtt[i] = (double)(now - start);
+    }
+
+    uint64_t start = monotonic_ns();
+    if (t->send(0, buf, size) != 0) goto fail;
+    for (int i = 0; i < iters; i++)
+        if (t->recv(0, buf, size) != 0) goto fail;
+    double elapsed = (double)(monotonic_ns() - start) / 1e9;
+    rc = 0;
+
+fail:
+    t->teardown(0);
+    waitpid(pid, &status, 0);
+    region_end();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) rc = -1;
+    if (rc == 0) {
+        qsort(one_way, 2 * iters, sizeof(double), compare_double);
+        qsort(rtt, iters, sizeof(double), compare_double);
+        r->one_way_p50 = percentile(one_way, 2 * iters, 50);
+        r->one_way_p99 = percentile(one_way, 2 * iters, 99);
+        r->rtt_p50 = percentile(rtt, iters, 50);
+        r->rtt_p99 = percentile(rtt, iters, 99);
+        r->msgs_per_sec = iters / elapsed;
+        r->bytes_per_sec = r->msgs_per_sec * size;
+    }
+
+out:
+    free(buf);
+    free(rtt);
+    if (one_way != MAP_FAILED) munmap(one_way, 2 * iters * sizeof(double));
+    return rc;
+}
+
+/* "8 B", "4 KB", "64 MB": exact for the powers of two the sweep uses */
+static const char* format_size(char* out, size_t len, size_t bytes) {
+    if (bytes >= (1 << 20) && bytes % (1 << 20) == 0) snprintf(out, len, "%zu MB", bytes >> 20);
+    else if (bytes >= 1024 && bytes % 1024 == 0) snprintf(out, len, "%zu KB", bytes >> 10);
+    else snprintf(out, len, "%zu B", bytes);
+    return out;
+}
+
+/* Size of the highest-level cache of CPU 0, from sysfs ("32768K") */
+static size_t llc_bytes(void) {
+    char path[128], text[32];
+    size_t best = 0;
+    int best_level = -1;
+    for (int idx = 0; idx < 16; idx++) {
+        int level = -1;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        FILE* fp = fopen(path, "r");
+        if (!fp) break;
+        if (fscanf(fp, "%d", &level) != 1) level = -1;
+        fclose(fp);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        if (level < best_level || !(fp = fopen(path, "r"))) continue;
+        if (fscanf(fp, "%31s", text) == 1) {
+            size_t value = strtoul(text, NULL, 10);
+            char unit = text[strspn(text, "0123456789")];
+            if (unit == 'K') value <<= 10;
+            else if (unit == 'M') value <<= 20;
+            best = value;
+            best_level = level;
+        }
+        fclose(fp);
+    }
+    return best;
+}
+
+/* Where a transport's curve bends: peak bandwidth, the half-bandwidth size
+ * (below it per-message cost dominates), how far RTT stays within 2x of the
+ * smallest message, and any size where bandwidth falls by more than 20% */
+static void print_bends(const char* name, const size_t sizes[], const IpcResult res[], const int ok[], int n) {
+    char a[24], b[24], c[24], d[24];
+    int peak = -1, half = -1, flat = -1, first = -1;
+
+    for (int i = 0; i < n; i++) {
+        if (!ok[i]) continue;
+        if (first < 0) first = i;
+        if (peak < 0 || res[i].bytes_per_sec > res[peak].bytes_per_sec) peak = i;
+    }
+    if (peak < 0) return;
+    for (int i = 0; i < n && half < 0; i++)
+        if (ok[i] && res[i].bytes_per_sec >= res[peak].bytes_per_sec / 2) half = i;
+    for (int i = first; i < n && ok[i] && res[i].rtt_p50 <= 2 * res[first].rtt_p50; i++) flat = i;
+
+    printf("%s: peak %.2f GB/s at %s, half of peak from %s, RTT within 2x of %s up to %s", name,
+           res[peak].bytes_per_sec / 1e9, format_size(a, sizeof(a), sizes[peak]),
+           format_size(b, sizeof(b), sizes[half]), format_size(c, sizeof(c), sizes[first]),
+           format_size(d, sizeof(d), sizes[flat]));
+    for (int i = first + 1, shown = 0; i < n; i++) {
+        if (!ok[i] || !ok[i - 1] || res[i].bytes_per_sec >= 0.8 * res[i - 1].bytes_per_sec) continue;
+        printf("%s%s", shown++ ? ", " : "; bandwidth drops at ", format_size(a, sizeof(a), sizes[i]));
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+
+    size_t size = SIZE, max_size = SWEEP_MAX;
+    size_t sizes[MAX_SIZES];
+    int iters = ITERATIONS, sweep = 0, num_sizes = 0;
+    int selected[NUM_TRANSPORTS];
+    static IpcResult results[NUM_TRANSPORTS][MAX_SIZES];
+    static int ok[NUM_TRANSPORTS][MAX_SIZES];
+
+    for (int k = 0; k < NUM_TRANSPORTS; k++) selected[k] = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            perf_enabled = 1;
+        } else if (strcmp(argv[i], "--transports") == 0 && i + 1 < argc) {
+            memset(selected, 0, sizeof(selected));
+            for (char* name = strtok(argv[++i], ","); name; name = strtok(NULL, ",")) {
+                int found = 0;
+                for (int k = 0; k < NUM_TRANSPORTS; k++)
+                    if (strcmp(name, transports[k].name) == 0) selected[k] = found = 1;
+                if (!found) {
+                    fprintf(stderr, "Unknown transport: %s\n", name);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            long s = atol(argv[++i]);
+            size = s < (long)sizeof(uint64_t) ? sizeof(uint64_t) : (size_t)s;
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = 1;
+        } else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            long s = atol(argv[++i]);
+            max_size = s < SWEEP_MIN ? SWEEP_MIN : (size_t)s;
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = atoi(argv[++i]);
+            if (iters < 1) iters = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--transports NAME,...] [--size BYTES | --sweep [--max-size BYTES]]\n"
+                    "          [--iters N] [--perf]\nTransports:", argv[0]);
+            for (int k = 0; k < NUM_TRANSPORTS; k++) fprintf(stderr, " %s", transports[k].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    if (sweep) {
+        for (size_t s = SWEEP_MIN; s <= max_size && num_sizes < MAX_SIZES; s *= 2) sizes[num_sizes++] = s;
+    } else {
+        sizes[num_sizes++] = size;
+    }
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2) spin_limit = 1;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), llc = llc_bytes();
+    char a[24], b[24], c[24], d[24];
+    if (sweep)
+        printf("Linux IPC Benchmark (parent <-> forked child; %s to %s messages, up to %d round trips and streamed; us)\n"
+               "Marked: page %s, LLC %s, and each transport's own buffer\n\n",
+               format_size(a, sizeof(a), sizes[0]), format_size(b, sizeof(b), sizes[num_sizes - 1]), iters,
+               format_size(c, sizeof(c), page), llc ? format_size(d, sizeof(d), llc) : "unknown");
+    else
+        printf("Linux IPC Benchmark (parent <-> forked child; %zu-byte messages, %d round trips and %d streamed; us)\n\n",
+               size, iters, iters);
+
+    if (perf_enabled) {
+        int opened = perf_open(&perf, 0);
+        if (opened < PERF_EVENTS)
+            fprintf(stderr, "perf_event_open: %d of %d counters available\n", opened, PERF_EVENTS);
+        printf("Counters per message, both processes (switches and migrations per 1k messages; - = not available):\n  %-20s", "");
+        perf_print_header(stdout);
+        printf("\n");
+    }
+
+    printf("%-14s %10s | %9s %9s | %9s %9s | %9s %10s\n", "Transport", "Size",
+           "1-way p50", "1-way p99", "RTT p50", "RTT p99", "GB/s", "Mmsgs/s");
+
+    for (int k = 0; k < NUM_TRANSPORTS; k++) {
+        if (!selected[k]) continue;
+        if (sweep && k > 0) printf("\n");
+
+        for (int z = 0; z < num_sizes; z++) {
+            IpcResult* r = &results[k][z];
+            long scaled = BYTES_BUDGET / (long)sizes[z];
+            int n = scaled < iters ? (int)scaled : iters;
+            if (n < MIN_ITERS) n = MIN_ITERS < iters ? MIN_ITERS : iters;
+            int warmup = n / 10 < WARMUP ? n / 10 : WARMUP;
+            if (warmup < 1) warmup = 1;
+
+            format_size(a, sizeof(a), sizes[z]);
+            ok[k][z] = run_transport(&transports[k], sizes[z], n, warmup, r) == 0;
+            if (!ok[k][z]) {
+                printf("%-14s %10s | failed\n", transports[k].name, a);
+                continue;
+            }
+            printf("%-14s %10s | %9.2f %9.2f | %9.2f %9.2f | %9.3f %10.3f", transports[k].name, a,
+                   r->one_way_p50 / 1e3, r->one_way_p99 / 1e3, r->rtt_p50 / 1e3, r->rtt_p99 / 1e3,
+                   r->bytes_per_sec / 1e9, r->msgs_per_sec / 1e6);
+            if (sweep) {
+                /* Mark the first size at or past each threshold */
+                size_t prev = z > 0 ? sizes[z - 1] : 0;
+                if (prev < page && sizes[z] >= page) printf("  <- page %s", format_size(b, sizeof(b), page));
+                if (r->capacity && prev < r->capacity && sizes[z] >= r->capacity)
+                    printf("  <- buffer %s", format_size(b, sizeof(b), r->capacity));
+                if (llc && prev < llc && sizes[z] >= llc) printf("  <- LLC %s", format_size(b, sizeof(b), llc));
+            }
+            printf("\n");
+            region_report(2L * (warmup + n) + n + 1);
+            fflush(stdout);
+        }
+    }
+
+    if (sweep) {
+        printf("\n");
+        for (int k = 0; k < NUM_TRANSPORTS; k++)
+            if (selected[k]) print_bends(transports[k].name, sizes, results[k], ok[k], num_sizes);
+    }
 
+    if (perf_enabled) perf_close(&perf);
     return 0;
 }
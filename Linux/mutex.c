@@ -1,56 +1,1994 @@
+/* Build: gcc -O2 -pthread mutex.c -o mutex -lm */
+
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <math.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <signal.h>
+#include "bench_common.h"
+#include "perf_counters.h"
+
+#define MAX_THREADS 256        /* Pool size cap; the default sweep stops at 2x online CPUs */
+#define MAX_SWEEP 64            /* Thread counts per sweep */
+#define DURATION_MS 200         /* Timed window per repetition */
+#define WARMUP_MS 50
+#define REPS 5
+#define CACHE_LINE 64
+#define MAX_BACKOFF 1024
+#define MAX_CPUS 1024
+#define FFWD_GROUP (CACHE_LINE / (int)sizeof(long))    /* Clients sharing one response line */
+#define LOW_PRIO_EVERY 4        /* Every 4th thread is in the low-priority group */
+#define FIFO_PRIORITY 10
+#define SHM_NAME "/mutex_bench"
+#define RECOVERY_TRIALS 20
+#define MAX_CS_LINES 4096       /* Shared buffer for --cs-lines: 256 KB */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define read_ticks() __rdtsc()
+#else
+#define read_ticks() monotonic_ns()
+#endif
+
+/* A lock under test: tid lets queue locks (MCS, CLH) find their per-thread node.
+ * Reader-writer locks also supply read_lock / read_unlock; the rest take the
+ * exclusive path for reads too */
+typedef struct {
+    const char* name;
+    void (*init)(void);
+    void (*lock)(int tid);
+    void (*unlock)(int tid);
+    void (*destroy)(void);
+    void (*read_lock)(int tid);
+    void (*read_unlock)(int tid);
+} LockImpl;
+
+/* A lock-free or sharded alternative to locking the shared counter */
+typedef struct {
+    const char* name;
+    void (*reset)(void);
+    void (*increment)(int tid);
+    long (*total)(void);
+} CounterImpl;
+
+/* Delegation: the caller hands its critical section to whichever thread is
+ * currently applying requests (a combiner or a dedicated server) */
+typedef struct {
+    const char* name;
+    int (*init)(int num_threads);       /* 0, or an errno value */
+    void (*execute)(int tid, int write);
+    void (*destroy)(void);
+} DelegateImpl;
+
+/* Counting wakeup channel, one per thread: post() lets one wait() through */
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_int count;     /* futex and spin-then-park */
+    atomic_int waiters;
+    atomic_int quit;                /* Set by the initiator to release a responder */
+    int pending;                    /* condvar */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    sem_t sem;
+    int efd;
+} HandoffChannel;
+
+typedef struct {
+    const char* name;
+    int (*init)(HandoffChannel* ch);    /* 0, or an errno value */
+    void (*wait)(HandoffChannel* ch);
+    void (*post)(HandoffChannel* ch);
+    void (*destroy)(HandoffChannel* ch);
+} HandoffImpl;
+
+typedef enum {
+    HANDOFF_PINGPONG,       /* Pairs (2k, 2k+1) bounce one token */
+    HANDOFF_ONE_TO_MANY     /* Thread 0 wakes every other thread and collects their acks */
+} HandoffPattern;
+
+/* One benchmark column: a lock around the critical section, a counter strategy,
+ * a delegation scheme, or a handoff primitive in one of the wakeup patterns */
+typedef struct {
+    const char* name;
+    const LockImpl* lock;
+    const CounterImpl* counter;
+    const DelegateImpl* delegate;
+    const HandoffImpl* handoff;
+    HandoffPattern pattern;
+} Mode;
+
+/* Per-thread results stay in the pool thread's own slot and are merged after each round */
+typedef struct {
+    _Alignas(CACHE_LINE) const Mode* mode;
+    int tid;
+    int record_latency;
+    uint64_t rng;               /* xorshift64 state for the read/write mix */
+    long ops;
+    long writes;                /* Ops that incremented counter */
+    PerfCounters pc;            /* Opened by the pool thread itself under --perf */
+    PerfSample perf;            /* Counter deltas over the timed window */
+    uint64_t max_wait;
+    uint64_t max_gap;           /* Longest time between two of this thread's ops */
+    pid_t ktid;                 /* Kernel thread id, for setpriority() */
+    long hist[HIST_BUCKETS];    /* Acquire-wait ticks, log-linear buckets */
+} WorkerArg;
+
+/* Where each CPU sits in the machine, as read from sysfs */
+typedef struct {
+    int cpu;
+    int core;               /* First CPU of its SMT sibling set */
+    int smt_index;          /* Position within the sibling set */
+    int smt_width;
+    int package;
+    int node;
+    int llc;                /* First CPU sharing its last-level cache */
+    int rank;               /* Scratch: spread order within node / LLC */
+} CpuTopo;
 
-#define MAX_THREADS 16
-#define ITERATIONS 1000000
+/* Thread i runs on cpus[i % count]; count == 0 leaves placement to the kernel */
+typedef struct {
+    const char* name;
+    int cpus[MAX_CPUS];
+    int count;
+} Placement;
+
+typedef struct {
+    double throughput;
+    double p50, p99, p999, max;     /* Acquire wait in ns */
+    double stall;                   /* Worst gap between one thread's ops, ns */
+    double jain;
+    long min_ops, max_ops;
+    long ops;
+    PerfSample perf;                /* Summed over the worker threads */
+    double ci;                      /* 95% half-width of mean throughput over repetitions */
+} RoundResult;
+
+/* Thread groups: every LOW_PRIO_EVERY-th thread runs at low priority, the rest high */
+typedef enum {
+    PRIO_NONE,
+    PRIO_NICE,      /* low = nice 19, high = nice 0 */
+    PRIO_FIFO       /* low = SCHED_OTHER, high = SCHED_FIFO (needs CAP_SYS_NICE) */
+} PrioMode;
+
+/* Everything forked workers share: lives in a shm_open segment */
+typedef struct {
+    pthread_mutex_t mutex;          /* PTHREAD_PROCESS_SHARED | PTHREAD_MUTEX_ROBUST */
+    long counter;
+    _Alignas(CACHE_LINE) atomic_int ready;
+    _Alignas(CACHE_LINE) atomic_int start;
+    _Alignas(CACHE_LINE) atomic_int stop;
+    _Alignas(CACHE_LINE) atomic_int done;          /* Workers that have left the window */
+    _Alignas(CACHE_LINE) atomic_int holding;       /* Recovery: victim owns the mutex */
+    atomic_int waiting;                             /* Recovery: waiter is about to block */
+    uint64_t recovered_ns;                          /* Recovery: when the waiter got the mutex */
+    int recovered_rc;
+    struct { _Alignas(CACHE_LINE) long ops; } slots[MAX_THREADS];
+    _Alignas(CACHE_LINE) long buf[MAX_CS_LINES][CACHE_LINE / sizeof(long)];
+} SharedBench;
+
+typedef struct {
+    int thread_counts[MAX_SWEEP];
+    int num_counts;
+    long duration_ms;
+    long warmup_ms;
+    int reps;
+    int record_latency;
+    int perf;
+} BenchConfig;
 
 pthread_mutex_t mutex;
 long counter = 0;
+_Alignas(CACHE_LINE) atomic_int stop_flag;
+_Alignas(CACHE_LINE) atomic_int start_flag;
+_Alignas(CACHE_LINE) atomic_int ready_count;
+_Alignas(CACHE_LINE) atomic_int done_count;
+WorkerArg worker_args[MAX_THREADS];
+pthread_t pool_threads[MAX_THREADS];
+int pool_size = 0;
+pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+long pool_generation = 0;       /* Bumped under pool_lock to start a round */
+int pool_active = 0;            /* Threads with tid < pool_active take part */
+int pool_exit = 0;
+int perf_enabled = 0;
+PrioMode prio_mode = PRIO_NONE;
+uint64_t window_start;          /* read_ticks() when start_flag was raised */
+double ns_per_tick = 1.0;
+CpuTopo topo[MAX_CPUS];
+int num_cpus = 0;
+double* c2c_lat = NULL;         /* --c2c: one-way transfer ns, c2c_count x c2c_count */
+int c2c_cpu[MAX_CPUS];          /* Matrix row -> CPU */
+int c2c_count = 0;
+
+/* Workload shape, shared by every worker: lines touched while holding the lock,
+ * busy time between acquisitions, and the share of acquisitions that only read */
+int cs_lines = 0;
+long think_ns = 0;
+uint64_t think_ticks = 0;
+int read_pct = 0;
+_Alignas(CACHE_LINE) volatile long shared_buf[MAX_CS_LINES][CACHE_LINE / sizeof(long)];
+volatile long read_sink;
 
-void* worker(void* arg) {
-    for(int i = 0; i < ITERATIONS; i++) {
-        pthread_mutex_lock(&mutex);
+/* Critical section body: a write bumps counter and one word in each of the
+ * first cs_lines lines of shared_buf; a read sums the same words */
+static inline void critical_section(int write) {
+    if (write) {
+        for (int k = 0; k < cs_lines; k++) shared_buf[k][0]++;
         counter++;
-        pthread_mutex_unlock(&mutex);
+    } else {
+        long sum = counter;
+        for (int k = 0; k < cs_lines; k++) sum += shared_buf[k][0];
+        read_sink = sum;
+    }
+}
+
+/* Harness waits (barriers, not locks under test): yield first, then sleep, so a
+ * SCHED_FIFO waiter cannot starve the lower-priority threads it is waiting for */
+static inline void barrier_wait(int* spins) {
+    if (++*spins < SPIN_LIMIT) {
+        sched_yield();
+    } else {
+        struct timespec ts = { 0, 50000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/* ==================================================================================
+ * PTHREAD LOCKS
+ * ================================================================================== */
+
+pthread_spinlock_t spinlock;
+
+static void pmutex_init(void) { pthread_mutex_init(&mutex, NULL); }
+static void pmutex_lock(int tid) { (void)tid; pthread_mutex_lock(&mutex); }
+static void pmutex_unlock(int tid) { (void)tid; pthread_mutex_unlock(&mutex); }
+static void pmutex_destroy(void) { pthread_mutex_destroy(&mutex); }
+
+static void adaptive_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+    pthread_mutex_init(&mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+pthread_rwlock_t rwlock;
+
+static void rwlock_init(void) { pthread_rwlock_init(&rwlock, NULL); }
+static void rwlock_wp_init(void) {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+static void rwlock_wrlock(int tid) { (void)tid; pthread_rwlock_wrlock(&rwlock); }
+static void rwlock_rdlock(int tid) { (void)tid; pthread_rwlock_rdlock(&rwlock); }
+static void rwlock_unlock(int tid) { (void)tid; pthread_rwlock_unlock(&rwlock); }
+static void rwlock_destroy(void) { pthread_rwlock_destroy(&rwlock); }
+
+/* Same mutex kind as the cross-process mode, used in-process for comparison */
+static void robust_mutex_init(pthread_mutex_t* m) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/* A robust lock may come back EOWNERDEAD: the caller owns it, but must repair it */
+static int robust_lock(pthread_mutex_t* m) {
+    int rc = pthread_mutex_lock(m);
+    if (rc == EOWNERDEAD) pthread_mutex_consistent(m);
+    return rc;
+}
+
+static void robust_init(void) { robust_mutex_init(&mutex); }
+static void robust_lock_tid(int tid) { (void)tid; robust_lock(&mutex); }
+
+/* Priority-inheritance mutex: a low-priority holder runs at its highest waiter's priority */
+static void pi_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static void pspin_init(void) { pthread_spin_init(&spinlock, PTHREAD_PROCESS_PRIVATE); }
+static void pspin_lock(int tid) { (void)tid; pthread_spin_lock(&spinlock); }
+static void pspin_unlock(int tid) { (void)tid; pthread_spin_unlock(&spinlock); }
+static void pspin_destroy(void) { pthread_spin_destroy(&spinlock); }
+
+/* ==================================================================================
+ * TEST-AND-TEST-AND-SET WITH EXPONENTIAL BACKOFF
+ * ================================================================================== */
+
+_Alignas(CACHE_LINE) atomic_int ttas_word;
+
+static void ttas_init(void) { atomic_init(&ttas_word, 0); }
+
+static void ttas_lock(int tid) {
+    (void)tid;
+    int backoff = 1, spins = 0;
+    for (;;) {
+        while (atomic_load_explicit(&ttas_word, memory_order_relaxed)) spin_wait(&spins);
+        if (!atomic_exchange_explicit(&ttas_word, 1, memory_order_acquire)) return;
+        for (int i = 0; i < backoff; i++) cpu_relax();
+        if (backoff < MAX_BACKOFF) backoff <<= 1;
+    }
+}
+
+static void ttas_unlock(int tid) {
+    (void)tid;
+    atomic_store_explicit(&ttas_word, 0, memory_order_release);
+}
+
+static void no_destroy(void) {}
+
+/* ==================================================================================
+ * TICKET LOCK
+ * ================================================================================== */
+
+_Alignas(CACHE_LINE) atomic_uint ticket_next;
+_Alignas(CACHE_LINE) atomic_uint ticket_serving;
+
+static void ticket_init(void) {
+    atomic_init(&ticket_next, 0);
+    atomic_init(&ticket_serving, 0);
+}
+
+static void ticket_lock(int tid) {
+    (void)tid;
+    int spins = 0;
+    unsigned my = atomic_fetch_add_explicit(&ticket_next, 1, memory_order_relaxed);
+    while (atomic_load_explicit(&ticket_serving, memory_order_acquire) != my) spin_wait(&spins);
+}
+
+static void ticket_unlock(int tid) {
+    (void)tid;
+    unsigned next = atomic_load_explicit(&ticket_serving, memory_order_relaxed) + 1;
+    atomic_store_explicit(&ticket_serving, next, memory_order_release);
+}
+
+/* ==================================================================================
+ * MCS QUEUE LOCK (each waiter spins on its own node)
+ * ================================================================================== */
+
+typedef struct McsNode {
+    _Alignas(CACHE_LINE) struct McsNode* _Atomic next;
+    atomic_int locked;
+} McsNode;
+
+McsNode mcs_nodes[MAX_THREADS];
+_Alignas(CACHE_LINE) McsNode* _Atomic mcs_tail;
+
+static void mcs_init(void) { atomic_init(&mcs_tail, NULL); }
+
+static void mcs_lock(int tid) {
+    McsNode* me = &mcs_nodes[tid];
+    int spins = 0;
+    atomic_store_explicit(&me->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&me->locked, 1, memory_order_relaxed);
+
+    McsNode* pred = atomic_exchange_explicit(&mcs_tail, me, memory_order_acq_rel);
+    if (pred) {
+        atomic_store_explicit(&pred->next, me, memory_order_release);
+        while (atomic_load_explicit(&me->locked, memory_order_acquire)) spin_wait(&spins);
+    }
+}
+
+static void mcs_unlock(int tid) {
+    McsNode* me = &mcs_nodes[tid];
+    int spins = 0;
+    McsNode* succ = atomic_load_explicit(&me->next, memory_order_acquire);
+
+    if (!succ) {
+        McsNode* expected = me;
+        if (atomic_compare_exchange_strong_explicit(&mcs_tail, &expected, NULL,
+                                                    memory_order_release, memory_order_relaxed))
+            return;
+        while (!(succ = atomic_load_explicit(&me->next, memory_order_acquire))) spin_wait(&spins);
+    }
+    atomic_store_explicit(&succ->locked, 0, memory_order_release);
+}
+
+/* ==================================================================================
+ * CLH QUEUE LOCK (each waiter spins on its predecessor's node)
+ * ================================================================================== */
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_int locked;
+} ClhNode;
+
+ClhNode clh_pool[MAX_THREADS + 1];
+ClhNode* clh_mine[MAX_THREADS];
+ClhNode* clh_pred[MAX_THREADS];
+_Alignas(CACHE_LINE) ClhNode* _Atomic clh_tail;
+
+static void clh_init(void) {
+    for (int i = 0; i <= MAX_THREADS; i++) atomic_init(&clh_pool[i].locked, 0);
+    for (int i = 0; i < MAX_THREADS; i++) clh_mine[i] = &clh_pool[i];
+    atomic_init(&clh_tail, &clh_pool[MAX_THREADS]);
+}
+
+static void clh_lock(int tid) {
+    ClhNode* me = clh_mine[tid];
+    int spins = 0;
+    atomic_store_explicit(&me->locked, 1, memory_order_relaxed);
+    ClhNode* pred = atomic_exchange_explicit(&clh_tail, me, memory_order_acq_rel);
+    clh_pred[tid] = pred;
+    while (atomic_load_explicit(&pred->locked, memory_order_acquire)) spin_wait(&spins);
+}
+
+static void clh_unlock(int tid) {
+    ClhNode* me = clh_mine[tid];
+    atomic_store_explicit(&me->locked, 0, memory_order_release);
+    clh_mine[tid] = clh_pred[tid];   /* Recycle the predecessor's node */
+}
+
+/* ==================================================================================
+ * RAW FUTEX MUTEX (0 = free, 1 = locked, 2 = locked with waiters)
+ * ================================================================================== */
+
+_Alignas(CACHE_LINE) atomic_int futex_word;
+
+static long sys_futex(atomic_int* addr, int op, int val) {
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static void futex_init(void) { atomic_init(&futex_word, 0); }
+
+static void futex_lock(int tid) {
+    (void)tid;
+    int c = 0;
+    if (atomic_compare_exchange_strong(&futex_word, &c, 1)) return;
+    if (c != 2) c = atomic_exchange(&futex_word, 2);
+    while (c != 0) {
+        sys_futex(&futex_word, FUTEX_WAIT_PRIVATE, 2);
+        c = atomic_exchange(&futex_word, 2);
+    }
+}
+
+static void futex_unlock(int tid) {
+    (void)tid;
+    if (atomic_fetch_sub(&futex_word, 1) != 1) {
+        atomic_store(&futex_word, 0);
+        sys_futex(&futex_word, FUTEX_WAKE_PRIVATE, 1);
+    }
+}
+
+static const LockImpl locks[] = {
+    { "pthread",  pmutex_init,  pmutex_lock, pmutex_unlock, pmutex_destroy, NULL, NULL },
+    { "adaptive", adaptive_init, pmutex_lock, pmutex_unlock, pmutex_destroy, NULL, NULL },
+    { "pi",       pi_init,       pmutex_lock, pmutex_unlock, pmutex_destroy, NULL, NULL },
+    { "robust",   robust_init,   robust_lock_tid, pmutex_unlock, pmutex_destroy, NULL, NULL },
+    { "spinlock", pspin_init,     pspin_lock,    pspin_unlock,    pspin_destroy, NULL, NULL },
+    { "ttas",     ttas_init,     ttas_lock,    ttas_unlock,    no_destroy, NULL, NULL },
+    { "ticket",   ticket_init,   ticket_lock,  ticket_unlock,  no_destroy, NULL, NULL },
+    { "mcs",      mcs_init,      mcs_lock,     mcs_unlock,     no_destroy, NULL, NULL },
+    { "clh",      clh_init,      clh_lock,     clh_unlock,     no_destroy, NULL, NULL },
+    { "futex",    futex_init,    futex_lock,   futex_unlock,   no_destroy, NULL, NULL },
+    { "rwlock",   rwlock_init,   rwlock_wrlock, rwlock_unlock, rwlock_destroy, rwlock_rdlock, rwlock_unlock },
+    { "rwlock-wp", rwlock_wp_init, rwlock_wrlock, rwlock_unlock, rwlock_destroy, rwlock_rdlock, rwlock_unlock },
+};
+
+#define NUM_LOCKS (int)(sizeof(locks) / sizeof(locks[0]))
+
+/* ==================================================================================
+ * COUNTERS WITHOUT A LOCK: ATOMIC, PER-THREAD (PADDED / PACKED), STRIPED
+ * ================================================================================== */
+
+#define MAX_STRIPES 64
+
+typedef struct { _Alignas(64) volatile long value; } Padded64;
+typedef struct { _Alignas(128) volatile long value; } Padded128;
+typedef struct { _Alignas(128) atomic_long value; } Stripe;
+
+_Alignas(CACHE_LINE) atomic_long atomic_counter;
+Padded64 padded64[MAX_THREADS];
+Padded128 padded128[MAX_THREADS];
+_Alignas(CACHE_LINE) volatile long packed[MAX_THREADS];   /* False-sharing baseline */
+Stripe stripes[MAX_STRIPES];
+int num_stripes = 4;
+
+static void atomic_reset(void) { atomic_store(&atomic_counter, 0); }
+static void atomic_increment(int tid) { (void)tid; atomic_fetch_add_explicit(&atomic_counter, 1, memory_order_relaxed); }
+static long atomic_total(void) { return atomic_load(&atomic_counter); }
+
+static void padded64_reset(void) { for (int i = 0; i < MAX_THREADS; i++) padded64[i].value = 0; }
+static void padded64_increment(int tid) { padded64[tid].value++; }
+static long padded64_total(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_THREADS; i++) sum += padded64[i].value;
+    return sum;
+}
+
+static void padded128_reset(void) { for (int i = 0; i < MAX_THREADS; i++) padded128[i].value = 0; }
+static void padded128_increment(int tid) { padded128[tid].value++; }
+static long padded128_total(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_THREADS; i++) sum += padded128[i].value;
+    return sum;
+}
+
+static void packed_reset(void) { for (int i = 0; i < MAX_THREADS; i++) packed[i] = 0; }
+static void packed_increment(int tid) { packed[tid]++; }
+static long packed_total(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_THREADS; i++) sum += packed[i];
+    return sum;
+}
+
+static void striped_reset(void) { for (int i = 0; i < MAX_STRIPES; i++) atomic_store(&stripes[i].value, 0); }
+static void striped_increment(int tid) {
+    atomic_fetch_add_explicit(&stripes[tid % num_stripes].value, 1, memory_order_relaxed);
+}
+static long striped_total(void) {
+    long sum = 0;
+    for (int i = 0; i < MAX_STRIPES; i++) sum += atomic_load(&stripes[i].value);
+    return sum;
+}
+
+static const CounterImpl counters[] = {
+    { "atomic",    atomic_reset,    atomic_increment,    atomic_total },
+    { "packed",    packed_reset,    packed_increment,    packed_total },
+    { "padded64",  padded64_reset,  padded64_increment,  padded64_total },
+    { "padded128", padded128_reset, padded128_increment, padded128_total },
+    { "striped",   striped_reset,   striped_increment,   striped_total },
+};
+
+#define NUM_COUNTERS (int)(sizeof(counters) / sizeof(counters[0]))
+
+/* ==================================================================================
+ * DELEGATION: FLAT COMBINING AND DEDICATED SERVER (FFWD)
+ * ================================================================================== */
+
+/* Flat combining: each thread publishes its request in its own slot, and
+ * whoever wins the combiner lock applies every pending request in one pass
+ * while the others spin on their own slot */
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_int pending;
+    int write;
+} FcSlot;
+
+FcSlot fc_slots[MAX_THREADS];
+_Alignas(CACHE_LINE) atomic_int fc_lock;
+int fc_threads;
+
+static int fc_init(int num_threads) {
+    fc_threads = num_threads;
+    atomic_init(&fc_lock, 0);
+    for (int i = 0; i < num_threads; i++) atomic_init(&fc_slots[i].pending, 0);
+    return 0;
+}
+
+static void fc_execute(int tid, int write) {
+    FcSlot* me = &fc_slots[tid];
+    int spins = 0;
+
+    me->write = write;
+    atomic_store_explicit(&me->pending, 1, memory_order_release);
+    for (;;) {
+        if (!atomic_load_explicit(&fc_lock, memory_order_relaxed) &&
+            !atomic_exchange_explicit(&fc_lock, 1, memory_order_acquire)) {
+            for (int i = 0; i < fc_threads; i++) {
+                FcSlot* slot = &fc_slots[i];
+                if (!atomic_load_explicit(&slot->pending, memory_order_acquire)) continue;
+                critical_section(slot->write);
+                atomic_store_explicit(&slot->pending, 0, memory_order_release);
+            }
+            atomic_store_explicit(&fc_lock, 0, memory_order_release);
+            return;
+        }
+        while (atomic_load_explicit(&fc_lock, memory_order_relaxed)) {
+            if (!atomic_load_explicit(&me->pending, memory_order_acquire)) return;
+            spin_wait(&spins);
+        }
+        if (!atomic_load_explicit(&me->pending, memory_order_acquire)) return;
+    }
+}
+
+static void fc_destroy(void) {}
+
+/* ffwd-style delegation: a dedicated server thread polls one request line
+ * per client and answers FFWD_GROUP clients with a single response-line
+ * write, so each batch costs the server one line transfer per group */
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long seq;
+    int write;
+    long next;                  /* Client-private sequence counter */
+} FfwdRequest;
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long seq[FFWD_GROUP];
+} FfwdResponse;
+
+FfwdRequest ffwd_req[MAX_THREADS];
+FfwdResponse ffwd_resp[(MAX_THREADS + FFWD_GROUP - 1) / FFWD_GROUP];
+long ffwd_served[MAX_THREADS];  /* Server-private copy of the response lines */
+_Alignas(CACHE_LINE) atomic_int ffwd_stop;
+pthread_t ffwd_server;
+int ffwd_threads;
+
+static void* ffwd_serve(void* arg) {
+    (void)arg;
+    int spins = 0;
+
+    while (!atomic_load_explicit(&ffwd_stop, memory_order_relaxed)) {
+        int served = 0;
+        for (int base = 0; base < ffwd_threads; base += FFWD_GROUP) {
+            int dirty = 0, end = base + FFWD_GROUP < ffwd_threads ? base + FFWD_GROUP : ffwd_threads;
+            for (int c = base; c < end; c++) {
+                long seq = atomic_load_explicit(&ffwd_req[c].seq, memory_order_acquire);
+                if (seq == ffwd_served[c]) continue;
+                critical_section(ffwd_req[c].write);
+                ffwd_served[c] = seq;
+                dirty = 1;
+            }
+            if (!dirty) continue;
+            for (int c = base; c < end; c++)
+                atomic_store_explicit(&ffwd_resp[base / FFWD_GROUP].seq[c - base], ffwd_served[c], memory_order_release);
+            served = 1;
+        }
+        if (served) spins = 0;
+        else spin_wait(&spins);
     }
     return NULL;
 }
 
-double get_time_sec() {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return ts.tv_sec + ts.tv_nsec / 1e9;
+static int ffwd_init(int num_threads) {
+    ffwd_threads = num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        atomic_init(&ffwd_req[i].seq, 0);
+        ffwd_req[i].next = 0;
+        ffwd_served[i] = 0;
+        atomic_init(&ffwd_resp[i / FFWD_GROUP].seq[i % FFWD_GROUP], 0);
+    }
+    atomic_init(&ffwd_stop, 0);
+    return pthread_create(&ffwd_server, NULL, ffwd_serve, NULL);
+}
+
+static void ffwd_execute(int tid, int write) {
+    FfwdRequest* req = &ffwd_req[tid];
+    atomic_long* resp = &ffwd_resp[tid / FFWD_GROUP].seq[tid % FFWD_GROUP];
+    long seq = ++req->next;
+    int spins = 0;
+
+    req->write = write;
+    atomic_store_explicit(&req->seq, seq, memory_order_release);
+    while (atomic_load_explicit(resp, memory_order_acquire) != seq) spin_wait(&spins);
+}
+
+static void ffwd_destroy(void) {
+    atomic_store_explicit(&ffwd_stop, 1, memory_order_relaxed);
+    pthread_join(ffwd_server, NULL);
+}
+
+static const DelegateImpl delegates[] = {
+    { "flatcomb", fc_init,   fc_execute,   fc_destroy },
+    { "ffwd",     ffwd_init, ffwd_execute, ffwd_destroy },
+};
+
+#define NUM_DELEGATES (int)(sizeof(delegates) / sizeof(delegates[0]))
+
+/* ==================================================================================
+ * HANDOFF PRIMITIVES: CONDVAR, SEMAPHORE, FUTEX, EVENTFD, SPIN-THEN-PARK
+ * ================================================================================== */
+
+HandoffChannel channels[MAX_THREADS];
+
+static int cond_init(HandoffChannel* ch) {
+    int rc = pthread_mutex_init(&ch->lock, NULL);
+    if (rc != 0) return rc;
+    if ((rc = pthread_cond_init(&ch->cond, NULL)) != 0) {
+        pthread_mutex_destroy(&ch->lock);
+        return rc;
+    }
+    ch->pending = 0;
+    return 0;
+}
+
+static void cond_wait(HandoffChannel* ch) {
+    pthread_mutex_lock(&ch->lock);
+    while (!ch->pending) pthread_cond_wait(&ch->cond, &ch->lock);
+    ch->pending--;
+    pthread_mutex_unlock(&ch->lock);
+}
+
+static void cond_post(HandoffChannel* ch) {
+    pthread_mutex_lock(&ch->lock);
+    ch->pending++;
+    pthread_mutex_unlock(&ch->lock);
+    pthread_cond_signal(&ch->cond);
+}
+
+static void cond_destroy(HandoffChannel* ch) {
+    pthread_cond_destroy(&ch->cond);
+    pthread_mutex_destroy(&ch->lock);
+}
+
+static int sem_channel_init(HandoffChannel* ch) { return sem_init(&ch->sem, 0, 0) == 0 ? 0 : errno; }
+static void sem_channel_wait(HandoffChannel* ch) { while (sem_wait(&ch->sem) != 0 && errno == EINTR) ; }
+static void sem_channel_post(HandoffChannel* ch) { sem_post(&ch->sem); }
+static void sem_channel_destroy(HandoffChannel* ch) { sem_destroy(&ch->sem); }
+
+static int count_init(HandoffChannel* ch) {
+    atomic_init(&ch->count, 0);
+    atomic_init(&ch->waiters, 0);
+    return 0;
+}
+
+static int count_try_take(HandoffChannel* ch) {
+    int c = atomic_load(&ch->count);
+    while (c > 0)
+        if (atomic_compare_exchange_weak(&ch->count, &c, c - 1)) return 1;
+    return 0;
+}
+
+/* Sleeps only while count is 0; waiters lets post() skip FUTEX_WAKE when no one sleeps */
+static void futex_channel_wait(HandoffChannel* ch) {
+    while (!count_try_take(ch)) {
+        atomic_fetch_add(&ch->waiters, 1);
+        sys_futex(&ch->count, FUTEX_WAIT_PRIVATE, 0);
+        atomic_fetch_sub(&ch->waiters, 1);
+    }
+}
+
+static void futex_channel_post(HandoffChannel* ch) {
+    atomic_fetch_add(&ch->count, 1);
+    if (atomic_load(&ch->waiters)) sys_futex(&ch->count, FUTEX_WAKE_PRIVATE, 1);
+}
+
+/* Polls for SPIN_LIMIT rounds before parking on the futex */
+static void spinpark_wait(HandoffChannel* ch) {
+    for (int spins = 0; spins < SPIN_LIMIT; spins++) {
+        if (count_try_take(ch)) return;
+        cpu_relax();
+    }
+    futex_channel_wait(ch);
+}
+
+static void count_destroy(HandoffChannel* ch) { (void)ch; }
+
+static int eventfd_init(HandoffChannel* ch) { return (ch->efd = eventfd(0, EFD_SEMAPHORE)) >= 0 ? 0 : errno; }
+
+static void eventfd_wait(HandoffChannel* ch) {
+    uint64_t v;
+    while (read(ch->efd, &v, sizeof(v)) != sizeof(v) && errno == EINTR) ;
+}
+
+static void eventfd_post(HandoffChannel* ch) {
+    uint64_t one = 1;
+    while (write(ch->efd, &one, sizeof(one)) != sizeof(one) && errno == EINTR) ;
+}
+
+static void eventfd_destroy(HandoffChannel* ch) { close(ch->efd); }
+
+static const HandoffImpl handoffs[] = {
+    { "cond",     cond_init,        cond_wait,          cond_post,          cond_destroy },
+    { "sem",      sem_channel_init, sem_channel_wait,   sem_channel_post,   sem_channel_destroy },
+    { "futex",    count_init,       futex_channel_wait, futex_channel_post, count_destroy },
+    { "eventfd",  eventfd_init,     eventfd_wait,       eventfd_post,       eventfd_destroy },
+    { "spinpark", count_init,       spinpark_wait,      futex_channel_post, count_destroy },
+};
+
+#define NUM_HANDOFFS (int)(sizeof(handoffs) / sizeof(handoffs[0]))
+#define FIRST_HANDOFF_MODE (NUM_LOCKS + NUM_COUNTERS + NUM_DELEGATES)
+#define NUM_MODES (FIRST_HANDOFF_MODE + 2 * NUM_HANDOFFS)
+
+/* ==================================================================================
+ * CPU TOPOLOGY AND THREAD PLACEMENT
+ * ================================================================================== */
+
+static const char* placement_names[] = { "none", "compact", "scatter", "smt", "llc", "cross-node", "c2c" };
+#define NUM_PLACEMENTS (int)(sizeof(placement_names) / sizeof(placement_names[0]))
+
+static int read_int_file(const char* path, int fallback) {
+    FILE* fp = fopen(path, "r");
+    int value = fallback;
+    if (!fp) return fallback;
+    if (fscanf(fp, "%d", &value) != 1) value = fallback;
+    fclose(fp);
+    return value;
+}
+
+/* Parses a sysfs CPU list such as "0-3,8,10-11" */
+static int read_cpu_list(const char* path, int cpus[], int max) {
+    FILE* fp = fopen(path, "r");
+    char buf[4096];
+    int count = 0;
+    if (!fp) return 0;
+    if (!fgets(buf, sizeof(buf), fp)) buf[0] = '\0';
+    fclose(fp);
+
+    for (char* tok = strtok(buf, ",\n"); tok && count < max; tok = strtok(NULL, ",\n")) {
+        int lo, hi;
+        if (sscanf(tok, "%d-%d", &lo, &hi) == 2) {
+            for (int c = lo; c <= hi && count < max; c++) cpus[count++] = c;
+        } else if (sscanf(tok, "%d", &lo) == 1) {
+            cpus[count++] = lo;
+        }
+    }
+    return count;
+}
+
+static int cpu_node(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    int node = 0;
+    if (!dir) return 0;
+    for (struct dirent* e; (e = readdir(dir)); ) {
+        if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+            node = atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+/* The LLC is the highest-level cache index; its first sharing CPU names it */
+static int cpu_llc(int cpu) {
+    char path[160];
+    int best_level = -1, llc = cpu, shared[MAX_CPUS];
+    for (int idx = 0; idx < 16; idx++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, idx);
+        int level = read_int_file(path, -1);
+        if (level < 0) break;
+        if (level < best_level) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, idx);
+        if (read_cpu_list(path, shared, MAX_CPUS) > 0) {
+            best_level = level;
+            llc = shared[0];
+        }
+    }
+    return llc;
+}
+
+void read_topology(void) {
+    int online[MAX_CPUS], siblings[MAX_CPUS];
+    char path[160];
+
+    num_cpus = read_cpu_list("/sys/devices/system/cpu/online", online, MAX_CPUS);
+    if (num_cpus == 0) {
+        num_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (num_cpus > MAX_CPUS) num_cpus = MAX_CPUS;
+        for (int i = 0; i < num_cpus; i++) online[i] = i;
+    }
+
+    for (int i = 0; i < num_cpus; i++) {
+        CpuTopo* t = &topo[i];
+        t->cpu = online[i];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", t->cpu);
+        int n = read_cpu_list(path, siblings, MAX_CPUS);
+        t->core = n > 0 ? siblings[0] : t->cpu;
+        t->smt_width = n > 0 ? n : 1;
+        t->smt_index = 0;
+        for (int k = 0; k < n; k++) if (siblings[k] == t->cpu) t->smt_index = k;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", t->cpu);
+        t->package = read_int_file(path, 0);
+        t->node = cpu_node(t->cpu);
+        t->llc = cpu_llc(t->cpu);
+    }
+}
+
+/* Compact order: siblings, then cores of one LLC, then LLCs, packages, nodes */
+static int compare_compact(const void* a, const void* b) {
+    const CpuTopo* x = a;
+    const CpuTopo* y = b;
+    if (x->node != y->node) return x->node - y->node;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->llc != y->llc) return x->llc - y->llc;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+/* Spread order: one thread per core before any sibling, rotating across
+ * nodes first and LLCs second */
+static int compare_spread(const void* a, const void* b) {
+    const CpuTopo* x = a;
+    const CpuTopo* y = b;
+    if (x->smt_index != y->smt_index) return x->smt_index - y->smt_index;
+    if (x->rank != y->rank) return x->rank - y->rank;
+    if (x->node != y->node) return x->node - y->node;
+    return x->cpu - y->cpu;
 }
 
-int main() {
+/* Loads the matrix written by c2c --out: "cpus N", N CPU ids, then N rows */
+int load_c2c(const char* path) {
+    FILE* fp = fopen(path, "r");
+    static int cpus[MAX_CPUS];
+    double* lat = NULL;
+    char word[16];
+    int n = 0, c;
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    while ((c = fgetc(fp)) == '#')
+        while ((c = fgetc(fp)) != '\n' && c != EOF) ;
+    if (c != EOF) ungetc(c, fp);
+
+    if (fscanf(fp, "%15s %d", word, &n) != 2 || strcmp(word, "cpus") != 0 || n < 2 || n > MAX_CPUS) goto bad;
+    if (!(lat = malloc(sizeof(double) * n * n))) {
+        perror("malloc");
+        fclose(fp);
+        return -1;
+    }
+    for (int i = 0; i < n; i++)
+        if (fscanf(fp, "%d", &cpus[i]) != 1) goto bad;
+    for (int i = 0; i < n * n; i++)
+        if (fscanf(fp, "%lf", &lat[i]) != 1) goto bad;
+    fclose(fp);
 
-    pthread_t threads[MAX_THREADS];
-    pthread_mutex_init(&mutex, NULL);
+    /* A later --c2c replaces the earlier matrix */
+    free(c2c_lat);
+    c2c_lat = lat;
+    memcpy(c2c_cpu, cpus, sizeof(int) * n);
+    c2c_count = n;
+    return 0;
 
-    printf("Linux Mutex Benchmark\n\n");
+bad:
+    fprintf(stderr, "%s: not a c2c matrix\n", path);
+    free(lat);
+    fclose(fp);
+    return -1;
+}
 
-    for(int num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2) {
+static int c2c_row(int cpu) {
+    for (int i = 0; i < c2c_count; i++)
+        if (c2c_cpu[i] == cpu) return i;
+    return -1;
+}
 
-        counter = 0;
-        double start = get_time_sec();
+/* Mean one-way transfer cost between the distinct CPUs that num_threads
+ * threads land on; 0 when they share one CPU, -1 when the matrix misses one.
+ * Unpinned threads are charged the mean over every measured pair */
+double c2c_expected(const Placement* p, int num_threads) {
+    int rows[MAX_CPUS], n = 0;
+    double sum = 0;
+    long pairs = 0;
 
-        for(int i = 0; i < num_threads; i++)
-            pthread_create(&threads[i], NULL, worker, NULL);
+    if (num_threads < 2) return 0;
+    if (p->count == 0) {
+        for (int i = 0; i < c2c_count; i++) rows[n++] = i;
+    } else {
+        for (int t = 0; t < num_threads && t < p->count; t++) {
+            int r = c2c_row(p->cpus[t]);
+            if (r < 0) return -1;
+            rows[n++] = r;
+        }
+    }
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            if (rows[i] != rows[j]) {
+                sum += c2c_lat[rows[i] * c2c_count + rows[j]];
+                pairs++;
+            }
+    return pairs ? sum / pairs : 0;
+}
 
-        for(int i = 0; i < num_threads; i++)
-            pthread_join(threads[i], NULL);
+/* Nearest-first order: the cheapest pair, then whichever CPU adds the least
+ * total transfer cost to the group so far (same greedy as c2c prints) */
+static int c2c_placement(Placement* p) {
+    int used[MAX_CPUS] = { 0 }, rows[MAX_CPUS], group[MAX_CPUS], n = 0;
+    if (!c2c_lat) return -1;
 
-        double end = get_time_sec();
+    for (int i = 0; i < num_cpus; i++) {
+        int r = c2c_row(topo[i].cpu);
+        if (r >= 0) rows[n++] = r;
+    }
+    if (n < 2) return -1;
 
-        double time_taken = end - start;
-        double throughput = counter / time_taken;
+    int a = 0, b = 1;
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            if (c2c_lat[rows[i] * c2c_count + rows[j]] < c2c_lat[rows[a] * c2c_count + rows[b]]) {
+                a = i;
+                b = j;
+            }
+    group[0] = rows[a];
+    group[1] = rows[b];
+    used[a] = used[b] = 1;
 
-        printf("Threads: %d | Throughput: %.0f ops/sec\n", num_threads, throughput);
+    for (int k = 2; k < n; k++) {
+        int pick = -1;
+        double pick_cost = 0;
+        for (int c = 0; c < n; c++) {
+            if (used[c]) continue;
+            double cost = 0;
+            for (int g = 0; g < k; g++) cost += c2c_lat[rows[c] * c2c_count + group[g]];
+            if (pick < 0 || cost < pick_cost) {
+                pick = c;
+                pick_cost = cost;
+            }
+        }
+        group[k] = rows[pick];
+        used[pick] = 1;
     }
+    for (int k = 0; k < n; k++) p->cpus[k] = c2c_cpu[group[k]];
+    p->count = n;
+    return 0;
+}
+
+/* Builds the CPU order for a policy; returns -1 when the machine cannot express it */
+int build_placement(const char* policy, Placement* p) {
+    CpuTopo sorted[MAX_CPUS];
+    int n = 0;
+
+    p->name = policy;
+    p->count = 0;
+    if (strcmp(policy, "none") == 0) return 0;
+
+    memcpy(sorted, topo, num_cpus * sizeof(CpuTopo));
+    n = num_cpus;
 
-    pthread_mutex_destroy(&mutex);
+    if (strcmp(policy, "compact") == 0) {
+        qsort(sorted, n, sizeof(CpuTopo), compare_compact);
+    } else if (strcmp(policy, "scatter") == 0) {
+        /* rank = core index within its LLC, then LLC index within its node */
+        qsort(sorted, n, sizeof(CpuTopo), compare_compact);
+        int llc_index = 0, core_in_llc = 0;
+        for (int i = 0; i < n; i++) {
+            if (i == 0 || sorted[i].node != sorted[i - 1].node) {
+                llc_index = 0;
+                core_in_llc = 0;
+            } else if (sorted[i].llc != sorted[i - 1].llc) {
+                llc_index++;
+                core_in_llc = 0;
+            } else if (sorted[i].core != sorted[i - 1].core) {
+                core_in_llc++;
+            }
+            sorted[i].rank = core_in_llc * MAX_CPUS + llc_index;
+        }
+        qsort(sorted, n, sizeof(CpuTopo), compare_spread);
+    } else if (strcmp(policy, "cross-node") == 0) {
+        /* Consecutive threads alternate nodes; within a node CPUs fill compactly */
+        qsort(sorted, n, sizeof(CpuTopo), compare_compact);
+        int in_node = 0, multi_node = 0;
+        for (int i = 0; i < n; i++) {
+            in_node = (i == 0 || sorted[i].node != sorted[i - 1].node) ? 0 : in_node + 1;
+            if (sorted[i].node != sorted[0].node) multi_node = 1;
+            sorted[i].rank = in_node;
+            sorted[i].smt_index = 0;    /* Sort by rank and node only */
+        }
+        if (!multi_node) return -1;
+        qsort(sorted, n, sizeof(CpuTopo), compare_spread);
+    } else if (strcmp(policy, "smt") == 0) {
+        qsort(sorted, n, sizeof(CpuTopo), compare_compact);
+        int k = 0;
+        for (int i = 0; i < n; i++) if (sorted[i].smt_width > 1) sorted[k++] = sorted[i];
+        n = k;
+    } else if (strcmp(policy, "c2c") == 0) {
+        return c2c_placement(p);
+    } else if (strcmp(policy, "llc") == 0) {
+        qsort(sorted, n, sizeof(CpuTopo), compare_compact);
+        int k = 0, llc = sorted[0].llc;
+        for (int i = 0; i < n; i++) if (sorted[i].llc == llc) sorted[k++] = sorted[i];
+        n = k;
+    } else {
+        return -1;
+    }
 
+    if (n == 0) return -1;
+    for (int i = 0; i < n; i++) p->cpus[i] = sorted[i].cpu;
+    p->count = n;
     return 0;
 }
+
+static void pin_thread(pthread_t thread, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+/* Converts read_ticks() units to nanoseconds against CLOCK_MONOTONIC */
+void calibrate_ticks(void) {
+    uint64_t ns0 = monotonic_ns(), t0 = read_ticks();
+    while (monotonic_ns() - ns0 < 20000000ULL) cpu_relax();
+    uint64_t ns1 = monotonic_ns(), t1 = read_ticks();
+    if (t1 > t0) ns_per_tick = (double)(ns1 - ns0) / (double)(t1 - t0);
+}
+
+/* Non-critical work between acquisitions: busy-waits think_ticks */
+static inline void think(void) {
+    if (!think_ticks) return;
+    uint64_t end = read_ticks() + think_ticks;
+    while (read_ticks() < end) cpu_relax();
+}
+
+static inline int pick_read(WorkerArg* w) {
+    if (!read_pct) return 0;
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    return (int)(w->rng % 100) < read_pct;
+}
+
+/* Adds the acquire wait since t0 to the thread's histogram and maximum */
+static inline void record_wait(WorkerArg* w, uint64_t t0) {
+    uint64_t wait = read_ticks() - t0;
+    w->hist[hist_bucket(wait)]++;
+    if (wait > w->max_wait) w->max_wait = wait;
+}
+
+/* Handoff round for one pool thread. The initiator (even tids in ping-pong,
+ * tid 0 in one-to-many) posts to its peers and waits for as many acks, timing
+ * each round trip; responders wait, ack, and leave once their quit flag is
+ * set. A thread without peers hands off to itself. Returns wakeups received */
+static long handoff_loop(WorkerArg* w) {
+    const HandoffImpl* h = w->mode->handoff;
+    int tid = w->tid, n = pool_active;
+    HandoffChannel* me = &channels[tid];
+    int initiator, first, last;
+    long wakeups = 0;
+
+    if (w->mode->pattern == HANDOFF_PINGPONG) {
+        initiator = !(tid & 1);
+        first = (tid ^ 1) < n ? tid ^ 1 : tid;
+        last = first + 1;
+    } else {
+        initiator = tid == 0;
+        first = n > 1 ? 1 : 0;
+        last = n;
+    }
+
+    if (!initiator) {
+        HandoffChannel* ack = &channels[w->mode->pattern == HANDOFF_PINGPONG ? tid ^ 1 : 0];
+        for (;;) {
+            h->wait(me);
+            if (atomic_load(&me->quit)) break;
+            wakeups++;
+            h->post(ack);
+        }
+        return wakeups;
+    }
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint64_t t0 = w->record_latency ? read_ticks() : 0;
+        for (int p = first; p < last; p++) h->post(&channels[p]);
+        for (int p = first; p < last; p++, wakeups++) h->wait(me);
+        if (w->record_latency) record_wait(w, t0);
+    }
+
+    for (int p = first; p < last; p++) {
+        if (p == tid) continue;
+        atomic_store(&channels[p].quit, 1);
+        h->post(&channels[p]);
+    }
+    return wakeups;
+}
+
+/* Pool threads park on pool_cond between rounds. Each round, the active ones
+ * meet at a start barrier (ready_count / start_flag) and run until main closes
+ * the timed window with stop_flag, so per-thread op counts show how evenly
+ * the lock was shared over the same interval */
+void run_worker(WorkerArg* w) {
+    const LockImpl* lock = w->mode->lock;
+    const DelegateImpl* delegate = w->mode->delegate;
+    void (*increment)(int) = w->mode->counter ? w->mode->counter->increment : NULL;
+    long i, writes = 0;
+
+    PerfSample before = { 0 }, after = { 0 };
+
+    atomic_fetch_add_explicit(&ready_count, 1, memory_order_release);
+    int spins = 0;
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) barrier_wait(&spins);
+    if (perf_enabled) {
+        perf_read(&w->pc, &before);
+        perf_rusage(&before, RUSAGE_THREAD);
+    }
+
+    uint64_t last = window_start;     /* A thread starved from the start counts as stalled */
+    if (w->mode->handoff) i = handoff_loop(w);
+    else for(i = 0; !atomic_load_explicit(&stop_flag, memory_order_relaxed); i++) {
+        uint64_t t0 = w->record_latency ? read_ticks() : 0;
+        if (w->record_latency) {
+            if (t0 - last > w->max_gap) w->max_gap = t0 - last;
+            last = t0;
+        }
+        if (lock) {
+            int read = pick_read(w);
+            if (read && lock->read_lock) lock->read_lock(w->tid);
+            else lock->lock(w->tid);
+            if (w->record_latency) record_wait(w, t0);
+            critical_section(!read);
+            if (read && lock->read_unlock) lock->read_unlock(w->tid);
+            else lock->unlock(w->tid);
+            writes += !read;
+        } else if (delegate) {
+            int read = pick_read(w);
+            delegate->execute(w->tid, !read);
+            if (w->record_latency) record_wait(w, t0);
+            writes += !read;
+        } else {
+            increment(w->tid);
+            writes++;
+            if (w->record_latency) record_wait(w, t0);
+        }
+        think();
+    }
+    if (w->record_latency && !w->mode->handoff && read_ticks() - last > w->max_gap) w->max_gap = read_ticks() - last;
+
+    if (perf_enabled) {
+        perf_read(&w->pc, &after);
+        perf_rusage(&after, RUSAGE_THREAD);
+        perf_delta(&w->perf, &before, &after);
+    }
+    w->ops = i;
+    w->writes = writes;
+    atomic_fetch_add_explicit(&done_count, 1, memory_order_release);
+}
+
+void* pool_worker(void* arg) {
+    WorkerArg* w = arg;
+    long seen = 0;
+
+    w->ktid = (pid_t)syscall(SYS_gettid);
+    if (perf_enabled) perf_open(&w->pc, 0);
+    for (;;) {
+        pthread_mutex_lock(&pool_lock);
+        while (pool_generation == seen && !pool_exit) pthread_cond_wait(&pool_cond, &pool_lock);
+        seen = pool_generation;
+        int active = w->tid < pool_active, quit = pool_exit;
+        pthread_mutex_unlock(&pool_lock);
+
+        if (quit) {
+            if (perf_enabled) perf_close(&w->pc);
+            return NULL;
+        }
+        if (active) run_worker(w);
+    }
+}
+
+void pool_stop(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_exit = 1;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 0; i < pool_size; i++) pthread_join(pool_threads[i], NULL);
+}
+
+/* Returns 0, or the pthread_create error after stopping the threads already started */
+int pool_start(int size) {
+    for (int i = 0; i < size; i++) {
+        worker_args[i].tid = i;
+        worker_args[i].rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+        int rc = pthread_create(&pool_threads[i], NULL, pool_worker, &worker_args[i]);
+        if (rc != 0) {
+            pool_size = i;
+            pool_stop();
+            return rc;
+        }
+    }
+    pool_size = size;
+    return 0;
+}
+
+/* Pins the first num_threads pool threads; threads beyond the placement's CPU
+ * list wrap around, and "none" hands every online CPU back to the kernel */
+void pool_place(const Placement* placement, int num_threads) {
+    cpu_set_t all;
+    CPU_ZERO(&all);
+    for (int c = 0; c < num_cpus; c++) CPU_SET(topo[c].cpu, &all);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (placement && placement->count > 0) pin_thread(pool_threads[i], placement->cpus[i % placement->count]);
+        else pthread_setaffinity_np(pool_threads[i], sizeof(all), &all);
+    }
+}
+
+static int is_low_prio(int tid) { return tid % LOW_PRIO_EVERY == 0; }
+
+/* Applies the priority groups to the pool. SCHED_FIFO needs privilege: if it
+ * is refused, the run falls back to nice groups and says so once */
+void pool_prioritize(int num_threads) {
+    if (prio_mode == PRIO_FIFO) {
+        struct sched_param high = { .sched_priority = FIFO_PRIORITY }, normal = { .sched_priority = 0 };
+        for (int i = 0; i < num_threads; i++) {
+            int low = is_low_prio(i);
+            if (pthread_setschedparam(pool_threads[i], low ? SCHED_OTHER : SCHED_FIFO, low ? &normal : &high) != 0) {
+                fprintf(stderr, "SCHED_FIFO not permitted; using nice groups instead\n");
+                prio_mode = PRIO_NICE;
+                break;
+            }
+        }
+    }
+    if (prio_mode == PRIO_NICE)
+        for (int i = 0; i < num_threads; i++) setpriority(PRIO_PROCESS, worker_args[i].ktid, is_low_prio(i) ? 19 : 0);
+}
+
+/* Runs one mode at one thread count for a window of duration_ms and merges the
+ * per-thread results. Only the window is timed: the pool already exists and
+ * the clock starts once every active thread is waiting at the barrier */
+RoundResult run_round(const Mode* mode, int num_threads, long duration_ms, int record_latency) {
+    RoundResult r;
+    static long merged[HIST_BUCKETS];
+
+    if (mode->lock) mode->lock->init();
+    else if (mode->delegate) {
+        int rc = mode->delegate->init(num_threads);
+        if (rc != 0) {
+            fprintf(stderr, "%s: %s\n", mode->name, strerror(rc));
+            exit(1);
+        }
+    }
+    else if (mode->handoff) {
+        for (int i = 0; i < num_threads; i++) {
+            int rc = mode->handoff->init(&channels[i]);
+            if (rc != 0) {
+                /* Passed the probe in main, so this is resource exhaustion mid-run */
+                fprintf(stderr, "%s: channel %d: %s\n", mode->name, i, strerror(rc));
+                exit(1);
+            }
+            atomic_store(&channels[i].quit, 0);
+        }
+    }
+    else mode->counter->reset();
+    counter = 0;
+    atomic_store(&stop_flag, 0);
+    atomic_store(&start_flag, 0);
+    atomic_store(&ready_count, 0);
+    atomic_store(&done_count, 0);
+
+    for(int i = 0; i < num_threads; i++) {
+        WorkerArg* w = &worker_args[i];
+        w->mode = mode;
+        w->record_latency = record_latency;
+        w->ops = 0;
+        w->max_wait = 0;
+        w->max_gap = 0;
+        if (record_latency) memset(w->hist, 0, sizeof(w->hist));
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    pool_active = num_threads;
+    pool_generation++;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+
+    int spins = 0;
+    while (atomic_load_explicit(&ready_count, memory_order_acquire) < num_threads) barrier_wait(&spins);
+    double start = get_time_sec();
+    window_start = read_ticks();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+
+    sleep_ms(duration_ms);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+    spins = 0;
+    while (atomic_load_explicit(&done_count, memory_order_acquire) < num_threads) barrier_wait(&spins);
+
+    double end = get_time_sec();
+    long total = counter;
+    if (mode->lock) mode->lock->destroy();
+    else if (mode->delegate) mode->delegate->destroy();
+    else if (mode->handoff) {
+        for (int i = 0; i < num_threads; i++) mode->handoff->destroy(&channels[i]);
+    }
+    else total = mode->counter->total();
+
+    long ops = 0, writes = 0, samples = 0;
+    double sum_sq = 0;
+    uint64_t max_wait = 0, max_gap = 0;
+    memset(merged, 0, sizeof(merged));
+    r.min_ops = r.max_ops = worker_args[0].ops;
+    for (int i = 0; i < num_threads; i++) {
+        WorkerArg* w = &worker_args[i];
+        ops += w->ops;
+        writes += w->writes;
+        sum_sq += (double)w->ops * w->ops;
+        if (w->ops < r.min_ops) r.min_ops = w->ops;
+        if (w->ops > r.max_ops) r.max_ops = w->ops;
+        if (w->max_wait > max_wait) max_wait = w->max_wait;
+        if (w->max_gap > max_gap) max_gap = w->max_gap;
+        if (perf_enabled) perf_accumulate(&r.perf, &w->perf, i == 0);
+        if (record_latency)
+            for (int b = 0; b < HIST_BUCKETS; b++) merged[b] += w->hist[b];
+    }
+    for (int b = 0; record_latency && b < HIST_BUCKETS; b++) samples += merged[b];
+
+    if (total != writes)
+        fprintf(stderr, "%s: lost updates (%ld of %ld)\n", mode->name, total, writes);
+
+    r.ops = ops;
+    r.throughput = ops / (end - start);
+    r.ci = 0;
+    r.jain = sum_sq > 0 ? (double)ops * ops / (num_threads * sum_sq) : 1.0;
+    r.p50 = record_latency ? hist_percentile(merged, samples, 50) * ns_per_tick : 0;
+    r.p99 = record_latency ? hist_percentile(merged, samples, 99) * ns_per_tick : 0;
+    r.p999 = record_latency ? hist_percentile(merged, samples, 99.9) * ns_per_tick : 0;
+    r.max = max_wait * ns_per_tick;
+    r.stall = max_gap * ns_per_tick;
+    return r;
+}
+
+/* Returns the median repetition (its fairness and latency figures come along
+ * with it) with ci set to the 95% confidence half-width of the mean throughput */
+RoundResult summarize(RoundResult reps[], int n) {
+    double rate[MAX_REPS];
+    for (int i = 0; i < n; i++) rate[i] = reps[i].throughput;
+
+    RepSummary sum = summarize_reps(rate, n);
+    RoundResult r = reps[sum.median_rep];
+    r.throughput = sum.median;
+    r.ci = sum.ci;
+    return r;
+}
+
+/* One discarded warmup window, then reps timed windows */
+RoundResult measure(const Mode* mode, int num_threads, const BenchConfig* cfg) {
+    static RoundResult reps[MAX_REPS];
+
+    if (cfg->warmup_ms > 0) run_round(mode, num_threads, cfg->warmup_ms, 0);
+    for (int i = 0; i < cfg->reps; i++)
+        reps[i] = run_round(mode, num_threads, cfg->duration_ms, cfg->record_latency);
+    return summarize(reps, cfg->reps);
+}
+
+/* Builds the mode table: every lock around the critical section, then the
+ * counter strategies, the delegation schemes, and each handoff primitive as
+ * pp-NAME (ping-pong) and 1n-NAME (one-to-many) */
+void init_modes(Mode modes[]) {
+    static char handoff_names[2 * NUM_HANDOFFS][16];
+
+    for (int i = 0; i < NUM_LOCKS; i++) modes[i] = (Mode){ locks[i].name, &locks[i], NULL, NULL, NULL, 0 };
+    for (int i = 0; i < NUM_COUNTERS; i++)
+        modes[NUM_LOCKS + i] = (Mode){ counters[i].name, NULL, &counters[i], NULL, NULL, 0 };
+    for (int i = 0; i < NUM_DELEGATES; i++)
+        modes[NUM_LOCKS + NUM_COUNTERS + i] = (Mode){ delegates[i].name, NULL, NULL, &delegates[i], NULL, 0 };
+    for (int i = 0; i < 2 * NUM_HANDOFFS; i++) {
+        HandoffPattern pattern = i < NUM_HANDOFFS ? HANDOFF_PINGPONG : HANDOFF_ONE_TO_MANY;
+        const HandoffImpl* h = &handoffs[i % NUM_HANDOFFS];
+        snprintf(handoff_names[i], sizeof(handoff_names[i]), "%s-%s", pattern == HANDOFF_PINGPONG ? "pp" : "1n", h->name);
+        modes[FIRST_HANDOFF_MODE + i] = (Mode){ handoff_names[i], NULL, NULL, NULL, h, pattern };
+    }
+}
+
+/* Parses a comma-separated mode list into a selection mask */
+int select_modes(const char* list, const Mode modes[], int selected[]) {
+    char buf[256];
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char* name = strtok(buf, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int i = 0; i < NUM_MODES; i++) {
+            if (strcmp(name, modes[i].name) == 0) selected[i] = found = 1;
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown mode: %s\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Parses a comma-separated placement list ("all" selects every policy) */
+int select_placements(const char* list, int selected[]) {
+    char buf[256];
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    memset(selected, 0, NUM_PLACEMENTS * sizeof(int));
+
+    for (char* name = strtok(buf, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int i = 0; i < NUM_PLACEMENTS; i++) {
+            if (strcmp(name, "all") == 0 || strcmp(name, placement_names[i]) == 0) selected[i] = found = 1;
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown placement: %s\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Default sweep: powers of two below 2x the online CPUs, plus exactly 1x and 2x */
+void default_thread_counts(BenchConfig* cfg) {
+    int online = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int limit = 2 * (online > 0 ? online : 1);
+    if (limit > MAX_THREADS) limit = MAX_THREADS;
+
+    cfg->num_counts = 0;
+    for (int n = 1; n <= limit; n++) {
+        int pow2 = (n & (n - 1)) == 0;
+        if (pow2 || n == online || n == limit) cfg->thread_counts[cfg->num_counts++] = n;
+    }
+}
+
+/* Runs the thread sweep for every selected mode under one placement policy */
+void run_sweep(const Mode modes[], const int selected[], const BenchConfig* cfg,
+               const Placement* placement) {
+    static RoundResult results[MAX_SWEEP][NUM_MODES];
+
+    printf("\nPlacement: %s", placement->name);
+    if (placement->count > 0) {
+        printf(" (CPU order:");
+        for (int i = 0; i < placement->count && i < 16; i++) printf(" %d", placement->cpus[i]);
+        printf("%s)", placement->count > 16 ? " ..." : "");
+    } else {
+        printf(" (kernel decides)");
+    }
+    printf("\n\n");
+    printf("%-8s", "Threads");
+    for (int m = 0; m < NUM_MODES; m++)
+        if (selected[m]) printf(" %17s", modes[m].name);
+    printf("\n");
+
+    for (int t = 0; t < cfg->num_counts; t++) {
+        int num_threads = cfg->thread_counts[t];
+        double baseline = 0, best = 0;
+        const char* best_name = NULL;
+
+        pool_place(placement, num_threads);
+        pool_prioritize(num_threads);
+        printf("%-8d", num_threads);
+        for (int m = 0; m < NUM_MODES; m++) {
+            if (!selected[m]) continue;
+            RoundResult* r = &results[t][m];
+            *r = measure(&modes[m], num_threads, cfg);
+            if (modes[m].lock == &locks[0]) baseline = r->throughput;
+            if (r->throughput > best) {
+                best = r->throughput;
+                best_name = modes[m].name;
+            }
+            printf(" %9.2f ±%6.2f", r->throughput / 1e6, r->ci / 1e6);
+            fflush(stdout);
+        }
+        if (baseline > 0 && best_name)
+            printf("   best: %s (%.1fx pthread)", best_name, best / baseline);
+        if (c2c_lat) {
+            /* A contended handover moves at least the lock word and the counter */
+            double c2c = c2c_expected(placement, num_threads);
+            if (c2c > 0) printf("   c2c %s%.0f ns, <= %.1f Mops", placement->count ? "" : "~", c2c, 1e3 / (2 * c2c));
+            else if (c2c == 0) printf("   c2c: no transfers");
+        }
+        printf("\n");
+    }
+
+    printf("\nFairness (Jain index over per-thread ops; 1.00 = perfectly even)%s, median repetition\n\n",
+           cfg->record_latency ? " and acquire-wait latency (ns; round trip for pp-/1n- handoff modes)" : "");
+    printf("%-8s %-12s %6s %10s %10s", "Threads", "Mode", "Jain", "min ops", "max ops");
+    if (cfg->record_latency) printf(" %9s %9s %9s %11s %11s", "p50", "p99", "p99.9", "max", "stall");
+    printf("\n");
+    for (int t = 0; t < cfg->num_counts; t++) {
+        for (int m = 0; m < NUM_MODES; m++) {
+            if (!selected[m]) continue;
+            RoundResult* r = &results[t][m];
+            printf("%-8d %-12s %6.3f %10ld %10ld", cfg->thread_counts[t], modes[m].name, r->jain, r->min_ops, r->max_ops);
+            if (cfg->record_latency) printf(" %9.0f %9.0f %9.0f %11.0f %11.0f", r->p50, r->p99, r->p999, r->max, r->stall);
+            printf("\n");
+        }
+    }
+
+    if (!cfg->perf) return;
+    printf("\nCounters per op (switches and migrations per 1k ops; - = not available), median repetition\n\n");
+    printf("%-8s %-12s", "Threads", "Mode");
+    perf_print_header(stdout);
+    printf("\n");
+    for (int t = 0; t < cfg->num_counts; t++) {
+        for (int m = 0; m < NUM_MODES; m++) {
+            if (!selected[m]) continue;
+            printf("%-8d %-12s", cfg->thread_counts[t], modes[m].name);
+            perf_print_row(stdout, &results[t][m].perf, results[t][m].ops);
+            printf("\n");
+        }
+    }
+
+}
+
+/* ==================================================================================
+ * CROSS-PROCESS ROBUST MUTEX
+ * ================================================================================== */
+
+/* Maps the shared segment. The name is unlinked straight away: forked workers
+ * inherit the mapping, and nothing is left behind in /dev/shm on a crash */
+SharedBench* shared_open(void) {
+    int fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(SharedBench)) != 0) {
+        perror("ftruncate");
+        close(fd);
+        shm_unlink(SHM_NAME);
+        return NULL;
+    }
+    SharedBench* sb = mmap(NULL, sizeof(SharedBench), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    shm_unlink(SHM_NAME);
+    return sb == MAP_FAILED ? NULL : sb;
+}
+
+/* Body of a forked worker: same barrier and window as the thread pool */
+static void process_worker(SharedBench* sb, int idx, const Placement* placement) {
+    long i;
+    int spins = 0;
+
+    if (placement && placement->count > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(placement->cpus[idx % placement->count], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    atomic_fetch_add(&sb->ready, 1);
+    while (!atomic_load_explicit(&sb->start, memory_order_acquire)) barrier_wait(&spins);
+
+    for (i = 0; !atomic_load_explicit(&sb->stop, memory_order_relaxed); i++) {
+        robust_lock(&sb->mutex);
+        for (int k = 0; k < cs_lines; k++) sb->buf[k][0]++;
+        sb->counter++;
+        pthread_mutex_unlock(&sb->mutex);
+        think();
+    }
+    sb->slots[idx].ops = i;
+    atomic_fetch_add_explicit(&sb->done, 1, memory_order_release);
+    _exit(0);
+}
+
+/* Forks num_procs workers on the shared robust mutex and times one window.
+ * Returns -1 if a fork fails, after releasing and reaping the workers already started */
+int run_process_round(SharedBench* sb, int num_procs, long duration_ms, const Placement* placement, RoundResult* out) {
+    pid_t pids[MAX_THREADS];
+    RoundResult r;
+    int spins = 0;
+
+    memset(&r, 0, sizeof(r));
+    robust_mutex_init(&sb->mutex);
+    sb->counter = 0;
+    atomic_store(&sb->ready, 0);
+    atomic_store(&sb->start, 0);
+    atomic_store(&sb->stop, 0);
+    atomic_store(&sb->done, 0);
+    fflush(stdout);
+
+    for (int i = 0; i < num_procs; i++) {
+        sb->slots[i].ops = 0;
+        pids[i] = fork();
+        if (pids[i] == 0) process_worker(sb, i, placement);
+        if (pids[i] < 0) {
+            perror("fork");
+            atomic_store(&sb->stop, 1);
+            atomic_store_explicit(&sb->start, 1, memory_order_release);
+            while (--i >= 0) waitpid(pids[i], NULL, 0);
+            pthread_mutex_destroy(&sb->mutex);
+            return -1;
+        }
+    }
+
+    while (atomic_load(&sb->ready) < num_procs) barrier_wait(&spins);
+    double start = get_time_sec();
+    atomic_store_explicit(&sb->start, 1, memory_order_release);
+    sleep_ms(duration_ms);
+    atomic_store_explicit(&sb->stop, 1, memory_order_relaxed);
+    /* The window ends when the last worker leaves it, not once exit and reaping are done */
+    for (spins = 0; atomic_load_explicit(&sb->done, memory_order_acquire) < num_procs; ) barrier_wait(&spins);
+    double end = get_time_sec();
+    for (int i = 0; i < num_procs; i++) waitpid(pids[i], NULL, 0);
+
+    long ops = 0;
+    double sum_sq = 0;
+    r.min_ops = r.max_ops = sb->slots[0].ops;
+    for (int i = 0; i < num_procs; i++) {
+        long n = sb->slots[i].ops;
+        ops += n;
+        sum_sq += (double)n * n;
+        if (n < r.min_ops) r.min_ops = n;
+        if (n > r.max_ops) r.max_ops = n;
+    }
+    if (sb->counter != ops)
+        fprintf(stderr, "processes: lost updates (%ld of %ld)\n", sb->counter, ops);
+
+    pthread_mutex_destroy(&sb->mutex);
+    r.ops = ops;
+    r.throughput = ops / (end - start);
+    r.jain = sum_sq > 0 ? (double)ops * ops / (num_procs * sum_sq) : 1.0;
+    *out = r;
+    return 0;
+}
+
+/* EOWNERDEAD recovery: a victim process takes the mutex and is SIGKILLed while
+ * a second process is blocked on it. Recovery time runs from kill() until the
+ * waiter's pthread_mutex_lock() returns, which covers the kernel walking the
+ * dead owner's robust list and waking the waiter. Returns -1 if a fork fails */
+int run_recovery(SharedBench* sb, int trials) {
+    static double samples[MAX_REPS];
+    int owner_dead = 0, spins;
+
+    if (trials > MAX_REPS) trials = MAX_REPS;
+    for (int t = 0; t < trials; t++) {
+        robust_mutex_init(&sb->mutex);
+        atomic_store(&sb->holding, 0);
+        atomic_store(&sb->waiting, 0);
+        fflush(stdout);
+
+        pid_t victim = fork();
+        if (victim < 0) {
+            perror("fork");
+            pthread_mutex_destroy(&sb->mutex);
+            return -1;
+        }
+        if (victim == 0) {
+            pthread_mutex_lock(&sb->mutex);
+            atomic_store(&sb->holding, 1);
+            for (;;) pause();
+        }
+        for (spins = 0; !atomic_load(&sb->holding); ) barrier_wait(&spins);
+
+        pid_t waiter = fork();
+        if (waiter == 0) {
+            atomic_store(&sb->waiting, 1);
+            int rc = robust_lock(&sb->mutex);
+            sb->recovered_ns = monotonic_ns();
+            sb->recovered_rc = rc;
+            pthread_mutex_unlock(&sb->mutex);
+            _exit(0);
+        }
+        if (waiter < 0) {
+            perror("fork");
+            kill(victim, SIGKILL);
+            waitpid(victim, NULL, 0);
+            pthread_mutex_destroy(&sb->mutex);
+            return -1;
+        }
+        for (spins = 0; !atomic_load(&sb->waiting); ) barrier_wait(&spins);
+        sleep_ms(2);            /* Let the waiter reach FUTEX_WAIT */
+
+        uint64_t killed = monotonic_ns();
+        kill(victim, SIGKILL);
+        waitpid(waiter, NULL, 0);
+        waitpid(victim, NULL, 0);
+
+        samples[t] = (double)(sb->recovered_ns - killed) / 1000.0;
+        owner_dead += sb->recovered_rc == EOWNERDEAD;
+        pthread_mutex_destroy(&sb->mutex);
+    }
+
+    double sorted[MAX_REPS];
+    memcpy(sorted, samples, trials * sizeof(double));
+    for (int i = 1; i < trials; i++)
+        for (int j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+            double tmp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = tmp;
+        }
+
+    printf("\nEOWNERDEAD recovery (holder SIGKILLed with one waiter blocked, %d trials)\n\n", trials);
+    printf("%-12s %10s %10s %10s %10s\n", "EOWNERDEAD", "min us", "p50 us", "p90 us", "max us");
+    printf("%5d of %-3d %10.1f %10.1f %10.1f %10.1f\n", owner_dead, trials, sorted[0], sorted[trials / 2],
+           sorted[(int)(trials * 0.9)], sorted[trials - 1]);
+    return 0;
+}
+
+/* Cross-process throughput beside the same robust mutex and a default mutex in-process.
+ * Returns -1 if a round could not fork its workers */
+int run_process_sweep(SharedBench* sb, const Mode modes[], const BenchConfig* cfg, const Placement* placement) {
+    static RoundResult reps[MAX_REPS];
+    const Mode *robust = NULL, *plain = NULL;
+
+    for (int m = 0; m < NUM_MODES; m++) {
+        if (modes[m].lock && strcmp(modes[m].name, "robust") == 0) robust = &modes[m];
+        if (modes[m].lock == &locks[0]) plain = &modes[m];
+    }
+
+    printf("\nCross-process robust mutex in shm_open memory, placement: %s\n\n", placement->name);
+    printf("%-8s %17s %17s %17s %8s\n", "Workers", "processes", "robust threads", "pthread threads", "Jain");
+
+    for (int t = 0; t < cfg->num_counts; t++) {
+        int n = cfg->thread_counts[t];
+
+        if (cfg->warmup_ms > 0 && run_process_round(sb, n, cfg->warmup_ms, placement, &reps[0]) != 0) return -1;
+        for (int i = 0; i < cfg->reps; i++)
+            if (run_process_round(sb, n, cfg->duration_ms, placement, &reps[i]) != 0) return -1;
+        RoundResult proc = summarize(reps, cfg->reps);
+
+        pool_place(placement, n);
+        RoundResult thr = measure(robust, n, cfg);
+        RoundResult def = measure(plain, n, cfg);
+
+        printf("%-8d %9.2f ±%6.2f %9.2f ±%6.2f %9.2f ±%6.2f %8.3f\n", n,
+               proc.throughput / 1e6, proc.ci / 1e6, thr.throughput / 1e6, thr.ci / 1e6,
+               def.throughput / 1e6, def.ci / 1e6, proc.jain);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+    Mode modes[NUM_MODES];
+    int selected[NUM_MODES];
+    int explicit_selection = 0;
+    int placement_selected[NUM_PLACEMENTS] = { 1 };
+    BenchConfig cfg = { .duration_ms = DURATION_MS, .warmup_ms = WARMUP_MS, .reps = REPS };
+    int cs_list[MAX_SWEEP] = { 0 }, num_cs = 1;
+    int processes = 0, recovery_trials = RECOVERY_TRIALS, status = 0;
+
+    init_modes(modes);
+    for (int i = 0; i < NUM_MODES; i++) selected[i] = i < FIRST_HANDOFF_MODE;
+    default_thread_counts(&cfg);
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--modes") == 0 || strcmp(argv[i], "--locks") == 0) && i + 1 < argc) {
+            if (!explicit_selection) memset(selected, 0, sizeof(selected));
+            explicit_selection = 1;
+            if (select_modes(argv[++i], modes, selected) != 0) return 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if ((cfg.num_counts = parse_thread_list(argv[++i], cfg.thread_counts, MAX_SWEEP, MAX_THREADS)) < 0) return 1;
+        } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            cfg.duration_ms = atol(argv[++i]);
+            if (cfg.duration_ms < 1) cfg.duration_ms = 1;
+        } else if (strcmp(argv[i], "--warmup-ms") == 0 && i + 1 < argc) {
+            cfg.warmup_ms = atol(argv[++i]);
+            if (cfg.warmup_ms < 0) cfg.warmup_ms = 0;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = atoi(argv[++i]);
+            if (cfg.reps < 1) cfg.reps = 1;
+            if (cfg.reps > MAX_REPS) cfg.reps = MAX_REPS;
+        } else if (strcmp(argv[i], "--c2c") == 0 && i + 1 < argc) {
+            if (load_c2c(argv[++i]) != 0) return 1;
+        } else if (strcmp(argv[i], "--placement") == 0 && i + 1 < argc) {
+            if (select_placements(argv[++i], placement_selected) != 0) return 1;
+        } else if (strcmp(argv[i], "--cs-lines") == 0 && i + 1 < argc) {
+            char* item = strtok(argv[++i], ",");
+            for (num_cs = 0; item && num_cs < MAX_SWEEP; item = strtok(NULL, ",")) {
+                int k = atoi(item);
+                cs_list[num_cs++] = k < 0 ? 0 : k > MAX_CS_LINES ? MAX_CS_LINES : k;
+            }
+        } else if (strcmp(argv[i], "--think-ns") == 0 && i + 1 < argc) {
+            think_ns = atol(argv[++i]);
+            if (think_ns < 0) think_ns = 0;
+        } else if (strcmp(argv[i], "--read-pct") == 0 && i + 1 < argc) {
+            read_pct = atoi(argv[++i]);
+            if (read_pct < 0) read_pct = 0;
+            if (read_pct > 100) read_pct = 100;
+        } else if (strcmp(argv[i], "--handoff") == 0) {
+            /* Wakeup benchmarks instead of the lock sweep; round trips are always timed */
+            if (!explicit_selection)
+                for (int m = 0; m < NUM_MODES; m++) selected[m] = m >= FIRST_HANDOFF_MODE;
+            explicit_selection = 1;
+            cfg.record_latency = 1;
+        } else if (strcmp(argv[i], "--oversub") == 0) {
+            /* 1x, 2x and 4x the online CPUs; preempted holders show up in the stall column */
+            int online = (int)sysconf(_SC_NPROCESSORS_ONLN);
+            if (online < 1) online = 1;
+            cfg.num_counts = 0;
+            for (int f = 1; f <= 4 && f * online <= MAX_THREADS; f *= 2) cfg.thread_counts[cfg.num_counts++] = f * online;
+            cfg.record_latency = 1;
+        } else if (strcmp(argv[i], "--prio") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "nice") == 0) prio_mode = PRIO_NICE;
+            else if (strcmp(argv[i], "fifo") == 0) prio_mode = PRIO_FIFO;
+            else {
+                fprintf(stderr, "Unknown priority mode: %s (nice or fifo)\n", argv[i]);
+                return 1;
+            }
+            cfg.record_latency = 1;
+        } else if (strcmp(argv[i], "--processes") == 0) {
+            processes = 1;
+        } else if (strcmp(argv[i], "--recovery-trials") == 0 && i + 1 < argc) {
+            recovery_trials = atoi(argv[++i]);
+            if (recovery_trials < 0) recovery_trials = 0;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            cfg.perf = 1;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            cfg.record_latency = 1;
+        } else if (strcmp(argv[i], "--stripes") == 0 && i + 1 < argc) {
+            num_stripes = atoi(argv[++i]);
+            if (num_stripes < 1) num_stripes = 1;
+            if (num_stripes > MAX_STRIPES) num_stripes = MAX_STRIPES;
+        } else {
+            fprintf(stderr, "Usage: %s [--modes NAME,...] [--threads N,...] [--duration-ms MS] [--warmup-ms MS]\n"
+                    "          [--reps N] [--stripes S] [--latency] [--perf] [--handoff]\n"
+                    "          [--oversub] [--prio nice|fifo] [--processes [--recovery-trials N]]\n"
+                    "          [--cs-lines K,...] [--think-ns NS] [--read-pct P]\n"
+                    "          [--placement none|compact|scatter|smt|llc|cross-node|c2c|all,...] [--c2c FILE]\nModes:", argv[0]);
+            for (int m = 0; m < NUM_MODES; m++) fprintf(stderr, " %s", modes[m].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    /* A handoff primitive that cannot be set up is skipped rather than timed */
+    for (int m = FIRST_HANDOFF_MODE; m < NUM_MODES; m++) {
+        HandoffChannel probe;
+        if (!selected[m]) continue;
+        int rc = modes[m].handoff->init(&probe);
+        if (rc != 0) {
+            fprintf(stderr, "Mode %s: not available (%s)\n", modes[m].name, strerror(rc));
+            selected[m] = 0;
+            continue;
+        }
+        modes[m].handoff->destroy(&probe);
+    }
+
+    if (cfg.record_latency || think_ns > 0) calibrate_ticks();
+    think_ticks = (uint64_t)(think_ns / ns_per_tick);
+    read_topology();
+
+    int pool = 0;
+    for (int t = 0; t < cfg.num_counts; t++)
+        if (cfg.thread_counts[t] > pool) pool = cfg.thread_counts[t];
+    perf_enabled = cfg.perf;
+    if (cfg.perf) {
+        PerfCounters probe;
+        int opened = perf_open(&probe, 0), switches = probe.fd[PERF_CTX_SWITCHES] >= 0;
+        perf_close(&probe);
+        if (opened < PERF_EVENTS)
+            fprintf(stderr, "perf_event_open: %d of %d counters available%s\n", opened, PERF_EVENTS,
+                    switches ? "" : "; context switches from getrusage");
+    }
+    int rc = pool_start(pool);
+    if (rc != 0) {
+        fprintf(stderr, "Thread pool: %s\n", strerror(rc));
+        return 1;
+    }
+
+    SharedBench* shared = NULL;
+    if (processes && !(shared = shared_open())) return 1;
+
+    if (prio_mode == PRIO_FIFO) {
+        /* Main closes the window, so it must outrank spinning FIFO workers */
+        struct sched_param above = { .sched_priority = FIFO_PRIORITY + 1 };
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &above);
+    }
+
+    printf("Linux Mutex Benchmark (throughput in Mops/sec: median ±95%% CI of %d x %ld ms windows, %ld ms warmup)\n",
+           cfg.reps, cfg.duration_ms, cfg.warmup_ms);
+    if (prio_mode != PRIO_NONE)
+        printf("Priority groups: every %dth thread (from 0) low, the rest high (%s)\n", LOW_PRIO_EVERY,
+               prio_mode == PRIO_FIFO ? "SCHED_OTHER vs SCHED_FIFO" : "nice 19 vs nice 0");
+
+    /* One sweep per critical-section size, so spin vs. sleep crossovers line up by hold time */
+    for (int c = 0; c < num_cs && !status; c++) {
+        cs_lines = cs_list[c];
+        printf("%sWorkload: %d cache line%s per critical section, %ld ns think time, %d%% reads\n",
+               c ? "\n" : "", cs_lines, cs_lines == 1 ? "" : "s", think_ns, read_pct);
+
+        for (int p = 0; p < NUM_PLACEMENTS && !status; p++) {
+            static Placement placement;
+            if (!placement_selected[p]) continue;
+            if (build_placement(placement_names[p], &placement) != 0) {
+                if (strcmp(placement_names[p], "c2c") == 0 && !c2c_lat) {
+                    printf("\nPlacement c2c: needs a matrix from --c2c FILE\n");
+                    continue;
+                }
+                printf("\nPlacement %s: not available on this machine (%d CPUs)\n", placement_names[p], num_cpus);
+                continue;
+            }
+            if (processes) status = run_process_sweep(shared, modes, &cfg, &placement) != 0;
+            else run_sweep(modes, selected, &cfg, &placement);
+        }
+    }
+
+    if (!status && processes && recovery_trials > 0) status = run_recovery(shared, recovery_trials) != 0;
+
+    pool_stop();
+    if (shared) munmap(shared, sizeof(SharedBench));
+    return status;
+}
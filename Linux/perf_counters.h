@@ -0,0 +1,161 @@
+/* Per-region hardware and kernel counters for the Linux benchmarks.
+ *
+ * Each counter is opened on its own (not as a group) so one unsupported event,
+ * typically the hardware ones inside a VM or under perf_event_paranoid, does
+ * not take the others down with it. Context switches always have a getrusage
+ * fallback, which also splits them into voluntary (blocked, e.g. in a futex
+ * wait) and involuntary (preempted).
+ *
+ * Usage: perf_open() once per thread to watch, perf_read() around the measured
+ * region, perf_delta() to subtract. getrusage can only see the calling thread
+ * (RUSAGE_THREAD) or process, so perf_rusage() is called from the thread or
+ * process being measured. */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_CTX_SWITCHES,
+    PERF_MIGRATIONS,
+    PERF_EVENTS
+};
+
+typedef struct {
+    int fd[PERF_EVENTS];
+} PerfCounters;
+
+typedef struct {
+    uint64_t value[PERF_EVENTS];    /* Scaled for multiplexing */
+    int valid[PERF_EVENTS];
+    long voluntary;                 /* getrusage context switches */
+    long involuntary;
+} PerfSample;
+
+static const struct { uint32_t type; uint64_t config; } perf_event_table[PERF_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+};
+
+/* Opens every event for thread tid (0 = the caller) on any CPU, following
+ * threads and processes it creates afterwards. Returns the number opened */
+static inline int perf_open(PerfCounters* pc, pid_t tid) {
+    int opened = 0;
+
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_event_table[e].type;
+        attr.config = perf_event_table[e].config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 1;
+        attr.exclude_hv = 1;
+        pc->fd[e] = (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0);
+        if (pc->fd[e] < 0) {
+            /* perf_event_paranoid >= 2 only allows user-space counting */
+            attr.exclude_kernel = 1;
+            pc->fd[e] = (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0);
+        }
+        if (pc->fd[e] >= 0) opened++;
+    }
+    return opened;
+}
+
+static inline void perf_close(PerfCounters* pc) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fd[e] >= 0) close(pc->fd[e]);
+        pc->fd[e] = -1;
+    }
+}
+
+/* Reads the counters; leaves the getrusage fields alone */
+static inline void perf_read(const PerfCounters* pc, PerfSample* s) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        uint64_t buf[3];        /* value, time enabled, time running */
+        s->valid[e] = 0;
+        s->value[e] = 0;
+        if (pc->fd[e] < 0 || read(pc->fd[e], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue;
+        if (buf[2] == 0) continue;      /* Never scheduled onto the PMU */
+        s->value[e] = buf[2] < buf[1] ? (uint64_t)((double)buf[0] * buf[1] / buf[2]) : buf[0];
+        s->valid[e] = 1;
+    }
+}
+
+/* who: RUSAGE_THREAD, RUSAGE_SELF or RUSAGE_CHILDREN */
+static inline void perf_rusage(PerfSample* s, int who) {
+    struct rusage ru;
+    s->voluntary = s->involuntary = 0;
+    if (getrusage(who, &ru) != 0) return;
+    s->voluntary = ru.ru_nvcsw;
+    s->involuntary = ru.ru_nivcsw;
+}
+
+static inline void perf_delta(PerfSample* out, const PerfSample* before, const PerfSample* after) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        out->valid[e] = before->valid[e] && after->valid[e];
+        out->value[e] = out->valid[e] ? after->value[e] - before->value[e] : 0;
+    }
+    out->voluntary = after->voluntary - before->voluntary;
+    out->involuntary = after->involuntary - before->involuntary;
+}
+
+/* Sums per-thread deltas; an event stays valid only if every thread had it */
+static inline void perf_accumulate(PerfSample* sum, const PerfSample* d, int first) {
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        sum->valid[e] = (first || sum->valid[e]) && d->valid[e];
+        sum->value[e] = (first ? 0 : sum->value[e]) + d->value[e];
+    }
+    sum->voluntary = (first ? 0 : sum->voluntary) + d->voluntary;
+    sum->involuntary = (first ? 0 : sum->involuntary) + d->involuntary;
+}
+
+/* Context switches from perf when it counted them, else from getrusage */
+static inline double perf_switches(const PerfSample* s) {
+    if (s->valid[PERF_CTX_SWITCHES]) return (double)s->value[PERF_CTX_SWITCHES];
+    return (double)(s->voluntary + s->involuntary);
+}
+
+static inline void perf_print_header(FILE* fp) {
+    fprintf(fp, " %9s %9s %5s %9s %8s %8s %8s %8s",
+            "cyc/op", "ins/op", "IPC", "LLCm/op", "cs/1k", "vol/1k", "invol/1k", "migr/1k");
+}
+
+static inline void perf_print_value(FILE* fp, int valid, double value, int width, int decimals) {
+    if (valid) fprintf(fp, " %*.*f", width, decimals, value);
+    else fprintf(fp, " %*s", width, "-");
+}
+
+/* Per-op derived values: cycles, instructions and LLC misses per op; switches
+ * and migrations per 1000 ops */
+static inline void perf_print_row(FILE* fp, const PerfSample* s, double ops) {
+    double k = ops > 0 ? 1000.0 / ops : 0;
+    int cyc = s->valid[PERF_CYCLES], ins = s->valid[PERF_INSTRUCTIONS];
+    if (ops <= 0) ops = 1;
+
+    perf_print_value(fp, cyc, s->value[PERF_CYCLES] / ops, 9, 1);
+    perf_print_value(fp, ins, s->value[PERF_INSTRUCTIONS] / ops, 9, 1);
+    perf_print_value(fp, cyc && ins && s->value[PERF_CYCLES],
+                     (double)s->value[PERF_INSTRUCTIONS] / (s->value[PERF_CYCLES] ? s->value[PERF_CYCLES] : 1), 5, 2);
+    perf_print_value(fp, s->valid[PERF_LLC_MISSES], s->value[PERF_LLC_MISSES] / ops, 9, 3);
+    perf_print_value(fp, 1, perf_switches(s) * k, 8, 2);
+    perf_print_value(fp, 1, s->voluntary * k, 8, 2);
+    perf_print_value(fp, 1, s->involuntary * k, 8, 2);
+    perf_print_value(fp, s->valid[PERF_MIGRATIONS], s->value[PERF_MIGRATIONS] * k, 8, 2);
+}
+
+#endif
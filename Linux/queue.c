@@ -0,0 +1,593 @@
+/* Build: gcc -O2 -pthread queue.c -o queue -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "bench_common.h"
+
+#define MAX_THREADS 64
+#define MAX_PAIRS 32
+#define CACHE_LINE 64
+#define CAPACITY 4096           /* Slots in the bounded queues, power of two */
+#define DURATION_MS 200
+#define WARMUP_MS 50
+#define REPS 5
+#define HAZARDS 2               /* Hazard pointers per thread (head and next) */
+#define RETIRE_SCAN (2 * HAZARDS * MAX_THREADS)
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define read_ticks() __rdtsc()
+#else
+#define read_ticks() monotonic_ns()
+#endif
+
+/* A queue under test. Items are non-zero 64-bit values (the enqueue timestamp);
+ * enqueue returns 0 when full and dequeue returns 0 when empty, and the
+ * harness spins and retries. tid is unique per thread across both roles */
+typedef struct {
+    const char* name;
+    int max_producers;
+    int max_consumers;
+    void (*init)(void);
+    int (*enqueue)(int tid, uint64_t value);
+    int (*dequeue)(int tid, uint64_t* value);
+    void (*destroy)(void);
+} QueueImpl;
+
+typedef struct {
+    _Alignas(CACHE_LINE) const QueueImpl* queue;
+    int tid;
+    int producer;
+    long ops;
+    long hist[HIST_BUCKETS];    /* Enqueue-to-dequeue ticks, consumers only */
+} WorkerArg;
+
+typedef struct {
+    double throughput;          /* Items dequeued per second */
+    double ci;
+    double p50, p99, p999;      /* End-to-end latency, ns */
+} RoundResult;
+
+typedef struct {
+    int producers[MAX_PAIRS];
+    int consumers[MAX_PAIRS];
+    int num_pairs;
+    long duration_ms;
+    long warmup_ms;
+    int reps;
+} BenchConfig;
+
+_Alignas(CACHE_LINE) atomic_int stop_flag;
+_Alignas(CACHE_LINE) atomic_int start_flag;
+_Alignas(CACHE_LINE) atomic_int ready_count;
+WorkerArg worker_args[MAX_THREADS];
+double ns_per_tick = 1.0;
+
+/* ==================================================================================
+ * SPSC RING (Lamport, with cached copies of the other side's index)
+ * ================================================================================== */
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_size_t head;    /* Next slot to read, owned by the consumer */
+    size_t cached_tail;
+    _Alignas(CACHE_LINE) atomic_size_t tail;    /* Next slot to write, owned by the producer */
+    size_t cached_head;
+    _Alignas(CACHE_LINE) uint64_t slots[CAPACITY];
+} SpscRing;
+
+SpscRing spsc;
+
+static void spsc_init(void) {
+    atomic_init(&spsc.head, 0);
+    atomic_init(&spsc.tail, 0);
+    spsc.cached_head = spsc.cached_tail = 0;
+}
+
+static int spsc_enqueue(int tid, uint64_t value) {
+    (void)tid;
+    size_t tail = atomic_load_explicit(&spsc.tail, memory_order_relaxed);
+    if (tail - spsc.cached_head == CAPACITY) {
+        spsc.cached_head = atomic_load_explicit(&spsc.head, memory_order_acquire);
+        if (tail - spsc.cached_head == CAPACITY) return 0;
+    }
+    spsc.slots[tail & (CAPACITY - 1)] = value;
+    atomic_store_explicit(&spsc.tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+static int spsc_dequeue(int tid, uint64_t* value) {
+    (void)tid;
+    size_t head = atomic_load_explicit(&spsc.head, memory_order_relaxed);
+    if (head == spsc.cached_tail) {
+        spsc.cached_tail = atomic_load_explicit(&spsc.tail, memory_order_acquire);
+        if (head == spsc.cached_tail) return 0;
+    }
+    *value = spsc.slots[head & (CAPACITY - 1)];
+    atomic_store_explicit(&spsc.head, head + 1, memory_order_release);
+    return 1;
+}
+
+static void no_destroy(void) {}
+
+/* ==================================================================================
+ * BOUNDED MPMC QUEUE (Vyukov: per-cell sequence numbers)
+ * ================================================================================== */
+
+typedef struct {
+    atomic_size_t seq;
+    uint64_t data;
+} VyukovCell;
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_size_t enqueue_pos;
+    _Alignas(CACHE_LINE) atomic_size_t dequeue_pos;
+    _Alignas(CACHE_LINE) VyukovCell cells[CAPACITY];
+} VyukovQueue;
+
+VyukovQueue vyukov;
+
+static void vyukov_init(void) {
+    for (size_t i = 0; i < CAPACITY; i++) atomic_init(&vyukov.cells[i].seq, i);
+    atomic_init(&vyukov.enqueue_pos, 0);
+    atomic_init(&vyukov.dequeue_pos, 0);
+}
+
+static int vyukov_enqueue(int tid, uint64_t value) {
+    (void)tid;
+    size_t pos = atomic_load_explicit(&vyukov.enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        VyukovCell* cell = &vyukov.cells[pos & (CAPACITY - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&vyukov.enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->data = value;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&vyukov.enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+static int vyukov_dequeue(int tid, uint64_t* value) {
+    (void)tid;
+    size_t pos = atomic_load_explicit(&vyukov.dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        VyukovCell* cell = &vyukov.cells[pos & (CAPACITY - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&vyukov.dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *value = cell->data;
+                atomic_store_explicit(&cell->seq, pos + CAPACITY, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&vyukov.dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+/* ==================================================================================
+ * MICHAEL-SCOTT QUEUE WITH HAZARD POINTERS
+ * ================================================================================== */
+
+typedef struct MsNode {
+    uint64_t value;
+    _Atomic(struct MsNode*) next;
+} MsNode;
+
+/* Each thread publishes the nodes it is about to dereference; a retired node
+ * is freed only once no hazard pointer names it */
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic(MsNode*) hazard[HAZARDS];
+    MsNode* retired[RETIRE_SCAN];
+    int num_retired;
+} MsThread;
+
+_Alignas(CACHE_LINE) _Atomic(MsNode*) ms_head;
+_Alignas(CACHE_LINE) _Atomic(MsNode*) ms_tail;
+_Alignas(CACHE_LINE) atomic_long ms_count;     /* Items in flight, at most CAPACITY */
+MsThread ms_threads[MAX_THREADS];
+
+static MsNode* ms_node(uint64_t value) {
+    MsNode* node = malloc(sizeof(MsNode));
+    if (!node) return NULL;
+    node->value = value;
+    atomic_init(&node->next, NULL);
+    return node;
+}
+
+static void ms_init(void) {
+    MsNode* dummy = ms_node(0);
+    if (!dummy) {
+        perror("malloc");
+        exit(1);
+    }
+    atomic_init(&ms_head, dummy);
+    atomic_init(&ms_tail, dummy);
+    atomic_init(&ms_count, 0);
+    for (int i = 0; i < MAX_THREADS; i++) {
+        for (int h = 0; h < HAZARDS; h++) atomic_init(&ms_threads[i].hazard[h], NULL);
+        ms_threads[i].num_retired = 0;
+    }
+}
+
+/* Loads *src into hazard slot h and re-checks it, so the node cannot have
+ * been retired between the load and the publication */
+static MsNode* ms_protect(int tid, int h, _Atomic(MsNode*)* src) {
+    MsNode* node = atomic_load(src);
+    for (;;) {
+        atomic_store(&ms_threads[tid].hazard[h], node);
+        MsNode* again = atomic_load(src);
+        if (again == node) return node;
+        node = again;
+    }
+}
+
+static void ms_scan(MsThread* self) {
+    MsNode* hazards[MAX_THREADS * HAZARDS];
+    int num_hazards = 0, kept = 0;
+
+    for (int i = 0; i < MAX_THREADS; i++)
+        for (int h = 0; h < HAZARDS; h++) {
+            MsNode* p = atomic_load(&ms_threads[i].hazard[h]);
+            if (p) hazards[num_hazards++] = p;
+        }
+
+    for (int r = 0; r < self->num_retired; r++) {
+        MsNode* node = self->retired[r];
+        int in_use = 0;
+        for (int h = 0; h < num_hazards && !in_use; h++) in_use = hazards[h] == node;
+        if (in_use) self->retired[kept++] = node;
+        else free(node);
+    }
+    self->num_retired = kept;
+}
+
+static void ms_retire(int tid, MsNode* node) {
+    MsThread* self = &ms_threads[tid];
+    self->retired[self->num_retired++] = node;
+    if (self->num_retired == RETIRE_SCAN) ms_scan(self);
+}
+
+/* Bounded like the rings: a slot is reserved in ms_count before the node is
+ * linked, so the list never holds more than CAPACITY items and a stalled
+ * consumer cannot let producers grow it without limit */
+static int ms_enqueue(int tid, uint64_t value) {
+    if (atomic_fetch_add_explicit(&ms_count, 1, memory_order_relaxed) >= CAPACITY) {
+        atomic_fetch_sub_explicit(&ms_count, 1, memory_order_relaxed);
+        return 0;
+    }
+    MsNode* node = ms_node(value);
+    if (!node) {
+        atomic_fetch_sub_explicit(&ms_count, 1, memory_order_relaxed);
+        return 0;
+    }
+    for (;;) {
+        MsNode* tail = ms_protect(tid, 0, &ms_tail);
+        MsNode* next = atomic_load(&tail->next);
+        if (tail != atomic_load(&ms_tail)) continue;
+        if (next) {
+            atomic_compare_exchange_weak(&ms_tail, &tail, next);
+            continue;
+        }
+        MsNode* expected = NULL;
+        if (atomic_compare_exchange_weak(&tail->next, &expected, node)) {
+            atomic_compare_exchange_strong(&ms_tail, &tail, node);
+            break;
+        }
+    }
+    atomic_store_explicit(&ms_threads[tid].hazard[0], NULL, memory_order_release);
+    return 1;
+}
+
+static int ms_dequeue(int tid, uint64_t* value) {
+    MsNode* head;
+    for (;;) {
+        head = ms_protect(tid, 0, &ms_head);
+        MsNode* tail = atomic_load(&ms_tail);
+        MsNode* next = ms_protect(tid, 1, &head->next);
+        if (head != atomic_load(&ms_head)) continue;
+        if (!next) {
+            atomic_store_explicit(&ms_threads[tid].hazard[0], NULL, memory_order_release);
+            return 0;
+        }
+        if (head == tail) {
+            atomic_compare_exchange_weak(&ms_tail, &tail, next);
+            continue;
+        }
+        *value = next->value;
+        if (atomic_compare_exchange_weak(&ms_head, &head, next)) break;
+    }
+    atomic_store_explicit(&ms_threads[tid].hazard[0], NULL, memory_order_release);
+    atomic_store_explicit(&ms_threads[tid].hazard[1], NULL, memory_order_release);
+    ms_retire(tid, head);
+    atomic_fetch_sub_explicit(&ms_count, 1, memory_order_relaxed);
+    return 1;
+}
+
+static void ms_destroy(void) {
+    MsNode* node = atomic_load(&ms_head);
+    while (node) {
+        MsNode* next = atomic_load(&node->next);
+        free(node);
+        node = next;
+    }
+    for (int i = 0; i < MAX_THREADS; i++) {
+        for (int r = 0; r < ms_threads[i].num_retired; r++) free(ms_threads[i].retired[r]);
+        ms_threads[i].num_retired = 0;
+    }
+}
+
+/* ==================================================================================
+ * MUTEX-PROTECTED RING
+ * ================================================================================== */
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t head, tail;
+    uint64_t slots[CAPACITY];
+} MutexRing;
+
+MutexRing mring;
+
+static void mring_init(void) {
+    pthread_mutex_init(&mring.lock, NULL);
+    mring.head = mring.tail = 0;
+}
+
+static int mring_enqueue(int tid, uint64_t value) {
+    (void)tid;
+    int ok = 0;
+    pthread_mutex_lock(&mring.lock);
+    if (mring.tail - mring.head < CAPACITY) {
+        mring.slots[mring.tail++ & (CAPACITY - 1)] = value;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&mring.lock);
+    return ok;
+}
+
+static int mring_dequeue(int tid, uint64_t* value) {
+    (void)tid;
+    int ok = 0;
+    pthread_mutex_lock(&mring.lock);
+    if (mring.head != mring.tail) {
+        *value = mring.slots[mring.head++ & (CAPACITY - 1)];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&mring.lock);
+    return ok;
+}
+
+static void mring_destroy(void) { pthread_mutex_destroy(&mring.lock); }
+
+static const QueueImpl queues[] = {
+    { "spsc",    1,           1,           spsc_init,    spsc_enqueue,    spsc_dequeue,    no_destroy },
+    { "vyukov",  MAX_THREADS, MAX_THREADS, vyukov_init,  vyukov_enqueue,  vyukov_dequeue,  no_destroy },
+    { "ms-hp",   MAX_THREADS, MAX_THREADS, ms_init,      ms_enqueue,      ms_dequeue,      ms_destroy },
+    { "mutex",   MAX_THREADS, MAX_THREADS, mring_init,   mring_enqueue,   mring_dequeue,   mring_destroy },
+};
+
+#define NUM_QUEUES (int)(sizeof(queues) / sizeof(queues[0]))
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+void calibrate_ticks(void) {
+    uint64_t ns0 = monotonic_ns(), t0 = read_ticks();
+    while (monotonic_ns() - ns0 < 20000000ULL) cpu_relax();
+    uint64_t ns1 = monotonic_ns(), t1 = read_ticks();
+    if (t1 > t0) ns_per_tick = (double)(ns1 - ns0) / (double)(t1 - t0);
+}
+
+/* Producers stamp each item with read_ticks(); consumers histogram the age of
+ * what they dequeue, so latency includes time spent waiting in the queue */
+void* worker(void* arg) {
+    WorkerArg* w = arg;
+    const QueueImpl* q = w->queue;
+    long ops = 0;
+    int spins = 0;
+
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) sched_yield();
+
+    if (w->producer) {
+        while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+            uint64_t stamp = read_ticks() | 1;
+            while (!q->enqueue(w->tid, stamp)) {
+                if (atomic_load_explicit(&stop_flag, memory_order_relaxed)) goto done;
+                spin_wait(&spins);
+            }
+            ops++;
+        }
+    } else {
+        while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+            uint64_t stamp;
+            if (!q->dequeue(w->tid, &stamp)) {
+                spin_wait(&spins);
+                continue;
+            }
+            uint64_t now = read_ticks();
+            w->hist[hist_bucket(now > stamp ? now - stamp : 0)]++;
+            ops++;
+        }
+    }
+done:
+    w->ops = ops;
+    return NULL;
+}
+
+/* One timed window; thread creation happens before the start barrier */
+RoundResult run_round(const QueueImpl* q, int producers, int consumers, long duration_ms) {
+    pthread_t threads[MAX_THREADS];
+    static long merged[HIST_BUCKETS];
+    int n = producers + consumers;
+    RoundResult r;
+
+    q->init();
+    atomic_store(&stop_flag, 0);
+    atomic_store(&start_flag, 0);
+    atomic_store(&ready_count, 0);
+
+    for (int i = 0; i < n; i++) {
+        WorkerArg* w = &worker_args[i];
+        w->queue = q;
+        w->tid = i;
+        w->producer = i < producers;
+        w->ops = 0;
+        memset(w->hist, 0, sizeof(w->hist));
+        int rc = pthread_create(&threads[i], NULL, worker, w);
+        if (rc != 0) {
+            atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+            atomic_store_explicit(&start_flag, 1, memory_order_release);
+            while (--i >= 0) pthread_join(threads[i], NULL);
+            q->destroy();
+            fprintf(stderr, "%s: %s\n", q->name, strerror(rc));
+            exit(1);
+        }
+    }
+
+    while (atomic_load(&ready_count) < n) sched_yield();
+    double start = get_time_sec();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    sleep_ms(duration_ms);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+    for (int i = 0; i < n; i++) pthread_join(threads[i], NULL);
+    double end = get_time_sec();
+    q->destroy();
+
+    long dequeued = 0;
+    memset(merged, 0, sizeof(merged));
+    for (int i = producers; i < n; i++) {
+        dequeued += worker_args[i].ops;
+        for (int b = 0; b < HIST_BUCKETS; b++) merged[b] += worker_args[i].hist[b];
+    }
+
+    r.throughput = dequeued / (end - start);
+    r.ci = 0;
+    r.p50 = hist_percentile(merged, dequeued, 50) * ns_per_tick;
+    r.p99 = hist_percentile(merged, dequeued, 99) * ns_per_tick;
+    r.p999 = hist_percentile(merged, dequeued, 99.9) * ns_per_tick;
+    return r;
+}
+
+/* Warmup window, then reps windows; returns the median one with a 95% CI */
+RoundResult measure(const QueueImpl* q, int producers, int consumers, const BenchConfig* cfg) {
+    static RoundResult reps[MAX_REPS];
+    double rate[MAX_REPS];
+
+    if (cfg->warmup_ms > 0) run_round(q, producers, consumers, cfg->warmup_ms);
+    for (int i = 0; i < cfg->reps; i++) {
+        reps[i] = run_round(q, producers, consumers, cfg->duration_ms);
+        rate[i] = reps[i].throughput;
+    }
+
+    RepSummary sum = summarize_reps(rate, cfg->reps);
+    RoundResult r = reps[sum.median_rep];
+    r.throughput = sum.median;
+    r.ci = sum.ci;
+    return r;
+}
+
+/* Parses "P:C,P:C,..." producer/consumer pairs */
+int parse_pairs(const char* list, BenchConfig* cfg) {
+    char buf[256];
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    cfg->num_pairs = 0;
+
+    for (char* item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+        int p, c;
+        if (sscanf(item, "%d:%d", &p, &c) != 2 || p < 1 || c < 1 || p + c > MAX_THREADS || cfg->num_pairs == MAX_PAIRS) {
+            fprintf(stderr, "Bad producer:consumer pair: %s\n", item);
+            return -1;
+        }
+        cfg->producers[cfg->num_pairs] = p;
+        cfg->consumers[cfg->num_pairs++] = c;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+    int selected[NUM_QUEUES];
+    BenchConfig cfg = { .duration_ms = DURATION_MS, .warmup_ms = WARMUP_MS, .reps = REPS };
+
+    for (int q = 0; q < NUM_QUEUES; q++) selected[q] = 1;
+    parse_pairs("1:1,1:2,2:1,2:2,4:4", &cfg);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--queues") == 0 && i + 1 < argc) {
+            char* name = strtok(argv[++i], ",");
+            memset(selected, 0, sizeof(selected));
+            for (; name; name = strtok(NULL, ",")) {
+                int found = 0;
+                for (int q = 0; q < NUM_QUEUES; q++)
+                    if (strcmp(name, queues[q].name) == 0) selected[q] = found = 1;
+                if (!found) {
+                    fprintf(stderr, "Unknown queue: %s\n", name);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--pairs") == 0 && i + 1 < argc) {
+            if (parse_pairs(argv[++i], &cfg) != 0) return 1;
+        } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            cfg.duration_ms = atol(argv[++i]);
+            if (cfg.duration_ms < 1) cfg.duration_ms = 1;
+        } else if (strcmp(argv[i], "--warmup-ms") == 0 && i + 1 < argc) {
+            cfg.warmup_ms = atol(argv[++i]);
+            if (cfg.warmup_ms < 0) cfg.warmup_ms = 0;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = atoi(argv[++i]);
+            if (cfg.reps < 1) cfg.reps = 1;
+            if (cfg.reps > MAX_REPS) cfg.reps = MAX_REPS;
+        } else {
+            fprintf(stderr, "Usage: %s [--queues NAME,...] [--pairs P:C,...] [--duration-ms MS] [--warmup-ms MS] [--reps N]\n"
+                    "Queues:", argv[0]);
+            for (int q = 0; q < NUM_QUEUES; q++) fprintf(stderr, " %s", queues[q].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    calibrate_ticks();
+
+    printf("Linux Queue Benchmark (%d-slot bounded queues; median ±95%% CI of %d x %ld ms windows, %ld ms warmup)\n\n",
+           CAPACITY, cfg.reps, cfg.duration_ms, cfg.warmup_ms);
+    printf("%-8s %-8s %17s %10s %10s %10s\n", "P:C", "Queue", "Mitems/sec", "p50 ns", "p99 ns", "p99.9 ns");
+
+    for (int p = 0; p < cfg.num_pairs; p++) {
+        char label[16];
+        snprintf(label, sizeof(label), "%d:%d", cfg.producers[p], cfg.consumers[p]);
+        for (int q = 0; q < NUM_QUEUES; q++) {
+            if (!selected[q]) continue;
+            if (cfg.producers[p] > queues[q].max_producers || cfg.consumers[p] > queues[q].max_consumers) continue;
+            RoundResult r = measure(&queues[q], cfg.producers[p], cfg.consumers[p], &cfg);
+            printf("%-8s %-8s %9.2f ±%6.2f %10.0f %10.0f %10.0f\n", label, queues[q].name,
+                   r.throughput / 1e6, r.ci / 1e6, r.p50, r.p99, r.p999);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,465 @@
+/* Build: gcc -O2 -pthread readmostly.c -o readmostly -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "bench_common.h"
+
+#define MAX_THREADS 256
+#define MAX_SWEEP 64
+#define MAX_RATIOS 16
+#define CACHE_LINE 64
+#define MAX_LINES 64            /* Size cap of the shared config, in cache lines */
+#define LINES 4
+#define WORDS_PER_LINE (CACHE_LINE / (int)sizeof(long))
+#define DURATION_MS 200
+#define WARMUP_MS 50
+#define REPS 5
+
+/* The shared, read-mostly object: every word holds the same version, so a
+ * reader can tell a torn snapshot from a consistent one */
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long words[MAX_LINES * WORDS_PER_LINE];
+} Config;
+
+/* A synchronization scheme: read() copies a consistent snapshot into out,
+ * write() installs a new version */
+typedef struct {
+    const char* name;
+    void (*init)(void);
+    void (*read)(int tid, long* out);
+    void (*write)(int tid, long version);
+    void (*destroy)(void);
+} SyncImpl;
+
+typedef struct {
+    _Alignas(CACHE_LINE) const SyncImpl* sync;
+    int tid;
+    uint64_t rng;
+    long reads;
+    long writes;
+    long torn;                  /* Inconsistent snapshots seen: must stay 0 */
+} WorkerArg;
+
+typedef struct {
+    double reads;               /* Reads per second */
+    double writes;
+    double ci;                  /* 95% half-width of mean read throughput */
+} RoundResult;
+
+typedef struct {
+    int thread_counts[MAX_SWEEP];
+    int num_counts;
+    long read_ratio[MAX_RATIOS];
+    long write_ratio[MAX_RATIOS];
+    int num_ratios;
+    long duration_ms;
+    long warmup_ms;
+    int reps;
+} BenchConfig;
+
+_Alignas(CACHE_LINE) atomic_int stop_flag;
+_Alignas(CACHE_LINE) atomic_int start_flag;
+_Alignas(CACHE_LINE) atomic_int ready_count;
+WorkerArg worker_args[MAX_THREADS];
+int num_words = LINES * WORDS_PER_LINE;
+long read_share, write_share;   /* Current ratio: write_share in (read_share + write_share) ops write */
+_Alignas(CACHE_LINE) atomic_long next_version;
+
+static void config_fill(Config* c, long version) {
+    for (int i = 0; i < num_words; i++) atomic_store_explicit(&c->words[i], version, memory_order_relaxed);
+}
+
+static void config_copy(const Config* c, long* out) {
+    for (int i = 0; i < num_words; i++) out[i] = atomic_load_explicit(&c->words[i], memory_order_relaxed);
+}
+
+/* ==================================================================================
+ * PTHREAD MUTEX AND RWLOCK
+ * ================================================================================== */
+
+Config shared;
+pthread_mutex_t mutex;
+pthread_rwlock_t rwlock;
+
+static void mutex_init(void) { pthread_mutex_init(&mutex, NULL); config_fill(&shared, 0); }
+static void mutex_destroy(void) { pthread_mutex_destroy(&mutex); }
+
+static void mutex_read(int tid, long* out) {
+    (void)tid;
+    pthread_mutex_lock(&mutex);
+    config_copy(&shared, out);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void mutex_write(int tid, long version) {
+    (void)tid;
+    pthread_mutex_lock(&mutex);
+    config_fill(&shared, version);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void rwlock_init(void) { pthread_rwlock_init(&rwlock, NULL); config_fill(&shared, 0); }
+static void rwlock_destroy(void) { pthread_rwlock_destroy(&rwlock); }
+
+static void rwlock_read(int tid, long* out) {
+    (void)tid;
+    pthread_rwlock_rdlock(&rwlock);
+    config_copy(&shared, out);
+    pthread_rwlock_unlock(&rwlock);
+}
+
+static void rwlock_write(int tid, long version) {
+    (void)tid;
+    pthread_rwlock_wrlock(&rwlock);
+    config_fill(&shared, version);
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* ==================================================================================
+ * SEQLOCK (readers never write shared memory; they retry if a writer overlapped)
+ * ================================================================================== */
+
+_Alignas(CACHE_LINE) atomic_ulong seq;
+_Alignas(CACHE_LINE) atomic_int seq_writer;     /* Serializes writers */
+
+static void seqlock_init(void) {
+    atomic_init(&seq, 0);
+    atomic_init(&seq_writer, 0);
+    config_fill(&shared, 0);
+}
+
+static void seqlock_read(int tid, long* out) {
+    (void)tid;
+    int spins = 0;
+    for (;;) {
+        unsigned long before = atomic_load_explicit(&seq, memory_order_acquire);
+        if (before & 1) {
+            spin_wait(&spins);
+            continue;
+        }
+        config_copy(&shared, out);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&seq, memory_order_relaxed) == before) return;
+    }
+}
+
+static void seqlock_write(int tid, long version) {
+    (void)tid;
+    int spins = 0;
+    while (atomic_exchange_explicit(&seq_writer, 1, memory_order_acquire)) spin_wait(&spins);
+    atomic_store_explicit(&seq, atomic_load_explicit(&seq, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    config_fill(&shared, version);
+    atomic_store_explicit(&seq, atomic_load_explicit(&seq, memory_order_relaxed) + 1, memory_order_release);
+    atomic_store_explicit(&seq_writer, 0, memory_order_release);
+}
+
+static void no_destroy(void) {}
+
+/* ==================================================================================
+ * EPOCH-BASED RCU (readers announce an epoch; writers copy, publish, then wait
+ * for every reader still in an older epoch before freeing the old copy)
+ * ================================================================================== */
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long epoch;    /* 0 = outside a read-side section */
+} RcuReader;
+
+_Alignas(CACHE_LINE) _Atomic(Config*) rcu_current;
+_Alignas(CACHE_LINE) atomic_long rcu_epoch;
+RcuReader rcu_readers[MAX_THREADS];
+pthread_mutex_t rcu_writer;
+
+static Config* rcu_alloc(long version) {
+    Config* c = aligned_alloc(CACHE_LINE, sizeof(Config));
+    config_fill(c, version);
+    return c;
+}
+
+static void rcu_init(void) {
+    atomic_init(&rcu_current, rcu_alloc(0));
+    atomic_init(&rcu_epoch, 1);
+    for (int i = 0; i < MAX_THREADS; i++) atomic_init(&rcu_readers[i].epoch, 0);
+    pthread_mutex_init(&rcu_writer, NULL);
+}
+
+static void rcu_read(int tid, long* out) {
+    RcuReader* me = &rcu_readers[tid];
+    atomic_store(&me->epoch, atomic_load(&rcu_epoch));
+    config_copy(atomic_load_explicit(&rcu_current, memory_order_acquire), out);
+    atomic_store_explicit(&me->epoch, 0, memory_order_release);
+}
+
+/* Waits out every reader that entered before the new epoch (a grace period) */
+static void rcu_synchronize(void) {
+    long epoch = atomic_fetch_add(&rcu_epoch, 1) + 1;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        int spins = 0;
+        for (;;) {
+            long e = atomic_load(&rcu_readers[i].epoch);
+            if (e == 0 || e >= epoch) break;
+            spin_wait(&spins);
+        }
+    }
+}
+
+static void rcu_write(int tid, long version) {
+    (void)tid;
+    Config* fresh = rcu_alloc(version);
+    pthread_mutex_lock(&rcu_writer);
+    Config* old = atomic_exchange(&rcu_current, fresh);
+    rcu_synchronize();
+    pthread_mutex_unlock(&rcu_writer);
+    free(old);
+}
+
+static void rcu_destroy(void) {
+    free(atomic_load(&rcu_current));
+    pthread_mutex_destroy(&rcu_writer);
+}
+
+static const SyncImpl syncs[] = {
+    { "mutex",   mutex_init,   mutex_read,   mutex_write,   mutex_destroy },
+    { "rwlock",  rwlock_init,  rwlock_read,  rwlock_write,  rwlock_destroy },
+    { "seqlock", seqlock_init, seqlock_read, seqlock_write, no_destroy },
+    { "epoch",   rcu_init,     rcu_read,     rcu_write,     rcu_destroy },
+};
+
+#define NUM_SYNCS (int)(sizeof(syncs) / sizeof(syncs[0]))
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+/* Each op is a write with probability write_share / (read_share + write_share) */
+void* worker(void* arg) {
+    WorkerArg* w = arg;
+    const SyncImpl* s = w->sync;
+    long snapshot[MAX_LINES * WORDS_PER_LINE];
+    long reads = 0, writes = 0, torn = 0;
+    uint64_t period = (uint64_t)(read_share + write_share);
+
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) sched_yield();
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        w->rng ^= w->rng << 13;
+        w->rng ^= w->rng >> 7;
+        w->rng ^= w->rng << 17;
+        if (w->rng % period < (uint64_t)write_share) {
+            s->write(w->tid, atomic_fetch_add_explicit(&next_version, 1, memory_order_relaxed));
+            writes++;
+        } else {
+            s->read(w->tid, snapshot);
+            for (int i = 1; i < num_words; i++)
+                if (snapshot[i] != snapshot[0]) {
+                    torn++;
+                    break;
+                }
+            reads++;
+        }
+    }
+
+    w->reads = reads;
+    w->writes = writes;
+    w->torn = torn;
+    return NULL;
+}
+
+RoundResult run_round(const SyncImpl* s, int num_threads, long duration_ms) {
+    pthread_t threads[MAX_THREADS];
+    RoundResult r = { 0, 0, 0 };
+
+    s->init();
+    atomic_store(&next_version, 1);
+    atomic_store(&stop_flag, 0);
+    atomic_store(&start_flag, 0);
+    atomic_store(&ready_count, 0);
+
+    for (int i = 0; i < num_threads; i++) {
+        WorkerArg* w = &worker_args[i];
+        w->sync = s;
+        w->tid = i;
+        w->rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+        int rc = pthread_create(&threads[i], NULL, worker, w);
+        if (rc != 0) {
+            atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+            atomic_store_explicit(&start_flag, 1, memory_order_release);
+            while (--i >= 0) pthread_join(threads[i], NULL);
+            s->destroy();
+            fprintf(stderr, "%s: %s\n", s->name, strerror(rc));
+            exit(1);
+        }
+    }
+
+    while (atomic_load(&ready_count) < num_threads) sched_yield();
+    double start = get_time_sec();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    sleep_ms(duration_ms);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    double end = get_time_sec();
+    s->destroy();
+
+    long reads = 0, writes = 0, torn = 0;
+    for (int i = 0; i < num_threads; i++) {
+        reads += worker_args[i].reads;
+        writes += worker_args[i].writes;
+        torn += worker_args[i].torn;
+    }
+    if (torn) fprintf(stderr, "%s: %ld torn reads\n", s->name, torn);
+
+    r.reads = reads / (end - start);
+    r.writes = writes / (end - start);
+    return r;
+}
+
+/* Warmup window, then reps windows; returns the median one with a 95% CI */
+RoundResult measure(const SyncImpl* s, int num_threads, const BenchConfig* cfg) {
+    static RoundResult reps[MAX_REPS];
+    double rate[MAX_REPS];
+
+    if (cfg->warmup_ms > 0) run_round(s, num_threads, cfg->warmup_ms);
+    for (int i = 0; i < cfg->reps; i++) {
+        reps[i] = run_round(s, num_threads, cfg->duration_ms);
+        rate[i] = reps[i].reads;
+    }
+
+    RepSummary sum = summarize_reps(rate, cfg->reps);
+    RoundResult r = reps[sum.median_rep];
+    r.reads = sum.median;
+    r.ci = sum.ci;
+    return r;
+}
+
+/* Parses "R:W,R:W,..." read:write ratios */
+int parse_ratios(const char* list, BenchConfig* cfg) {
+    char buf[256];
+    strncpy(buf, list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    cfg->num_ratios = 0;
+
+    for (char* item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+        long r, w;
+        if (sscanf(item, "%ld:%ld", &r, &w) != 2 || r < 0 || w < 0 || r + w == 0 || cfg->num_ratios == MAX_RATIOS) {
+            fprintf(stderr, "Bad read:write ratio: %s\n", item);
+            return -1;
+        }
+        cfg->read_ratio[cfg->num_ratios] = r;
+        cfg->write_ratio[cfg->num_ratios++] = w;
+    }
+    return 0;
+}
+
+/* Default sweep: powers of two up to the online CPUs, plus exactly that many */
+void default_thread_counts(BenchConfig* cfg) {
+    int online = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    if (online > MAX_THREADS) online = MAX_THREADS;
+
+    cfg->num_counts = 0;
+    for (int n = 1; n <= online; n++)
+        if ((n & (n - 1)) == 0 || n == online) cfg->thread_counts[cfg->num_counts++] = n;
+}
+
+int main(int argc, char* argv[]) {
+
+    BenchConfig cfg = { .duration_ms = DURATION_MS, .warmup_ms = WARMUP_MS, .reps = REPS };
+    int selected[NUM_SYNCS];
+    static RoundResult results[MAX_SWEEP][NUM_SYNCS];
+
+    for (int s = 0; s < NUM_SYNCS; s++) selected[s] = 1;
+    default_thread_counts(&cfg);
+    parse_ratios("1000:1,100:1,10:1", &cfg);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--schemes") == 0 && i + 1 < argc) {
+            char* name = strtok(argv[++i], ",");
+            memset(selected, 0, sizeof(selected));
+            for (; name; name = strtok(NULL, ",")) {
+                int found = 0;
+                for (int s = 0; s < NUM_SYNCS; s++)
+                    if (strcmp(name, syncs[s].name) == 0) selected[s] = found = 1;
+                if (!found) {
+                    fprintf(stderr, "Unknown scheme: %s\n", name);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--ratio") == 0 && i + 1 < argc) {
+            if (parse_ratios(argv[++i], &cfg) != 0) return 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if ((cfg.num_counts = parse_thread_list(argv[++i], cfg.thread_counts, MAX_SWEEP, MAX_THREADS)) < 0) return 1;
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            int lines = atoi(argv[++i]);
+            if (lines < 1) lines = 1;
+            if (lines > MAX_LINES) lines = MAX_LINES;
+            num_words = lines * WORDS_PER_LINE;
+        } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            cfg.duration_ms = atol(argv[++i]);
+            if (cfg.duration_ms < 1) cfg.duration_ms = 1;
+        } else if (strcmp(argv[i], "--warmup-ms") == 0 && i + 1 < argc) {
+            cfg.warmup_ms = atol(argv[++i]);
+            if (cfg.warmup_ms < 0) cfg.warmup_ms = 0;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = atoi(argv[++i]);
+            if (cfg.reps < 1) cfg.reps = 1;
+            if (cfg.reps > MAX_REPS) cfg.reps = MAX_REPS;
+        } else {
+            fprintf(stderr, "Usage: %s [--schemes NAME,...] [--ratio R:W,...] [--threads N,...] [--lines L]\n"
+                    "          [--duration-ms MS] [--warmup-ms MS] [--reps N]\nSchemes:", argv[0]);
+            for (int s = 0; s < NUM_SYNCS; s++) fprintf(stderr, " %s", syncs[s].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    printf("Linux Read-Mostly Benchmark (%d-line config; Mreads/sec: median ±95%% CI of %d x %ld ms windows)\n",
+           num_words / WORDS_PER_LINE, cfg.reps, cfg.duration_ms);
+
+    for (int q = 0; q < cfg.num_ratios; q++) {
+        read_share = cfg.read_ratio[q];
+        write_share = cfg.write_ratio[q];
+        printf("\nRead:write %ld:%ld\n\n%-8s", read_share, write_share, "Threads");
+        for (int s = 0; s < NUM_SYNCS; s++)
+            if (selected[s]) printf(" %17s", syncs[s].name);
+        printf("\n");
+
+        for (int t = 0; t < cfg.num_counts; t++) {
+            printf("%-8d", cfg.thread_counts[t]);
+            for (int s = 0; s < NUM_SYNCS; s++) {
+                if (!selected[s]) continue;
+                RoundResult* r = &results[t][s];
+                *r = measure(&syncs[s], cfg.thread_counts[t], &cfg);
+                printf(" %9.2f ±%6.2f", r->reads / 1e6, r->ci / 1e6);
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+
+        /* Reader scaling relative to the first row, and the writes that got through */
+        printf("\n%-8s", "Scaling");
+        for (int s = 0; s < NUM_SYNCS; s++)
+            if (selected[s]) printf(" %17s", syncs[s].name);
+        printf("\n");
+        for (int t = 0; t < cfg.num_counts; t++) {
+            printf("%-8d", cfg.thread_counts[t]);
+            for (int s = 0; s < NUM_SYNCS; s++) {
+                if (!selected[s]) continue;
+                double base = results[0][s].reads;
+                printf(" %7.2fx %6.0fk/s", base > 0 ? results[t][s].reads / base : 0, results[t][s].writes / 1e3);
+            }
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,322 @@
+/* Build: gcc -O2 -pthread spawn.c -o spawn -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define MAX_ITERS 100000
+#define ITERS 500
+#define WARMUP 20
+#define RSS_MB 256              /* Parent working set for fork-large */
+#define CLONE_STACK (64 * 1024)
+#define CHILD_FLAG "--spawn-child"
+
+extern char** environ;
+
+/* A creation method: start() launches a child that stamps *first_ns with
+ * CLOCK_MONOTONIC as its first action; reap() waits for it to be gone. Both
+ * return 0 or an errno value */
+typedef struct {
+    const char* name;
+    int (*setup)(void);
+    int (*start)(void);
+    int (*reap)(void);
+    void (*teardown)(void);
+} SpawnImpl;
+
+typedef struct {
+    double p50, p99, p999, max, mean;
+} Percentiles;
+
+volatile uint64_t* first_ns;    /* MAP_SHARED so forked children can write it */
+const char* self_path = "/proc/self/exe";
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int no_setup(void) { return 0; }
+static void no_teardown(void) {}
+
+/* ==================================================================================
+ * PTHREAD_CREATE
+ * ================================================================================== */
+
+pthread_t child_thread;
+
+static void* thread_body(void* arg) {
+    (void)arg;
+    *first_ns = monotonic_ns();
+    return NULL;
+}
+
+static int thread_start(void) { return pthread_create(&child_thread, NULL, thread_body, NULL); }
+static int thread_reap(void) { return pthread_join(child_thread, NULL); }
+
+/* ==================================================================================
+ * FORK, VFORK AND CLONE (the parent reaps with waitpid)
+ * ================================================================================== */
+
+pid_t child_pid;
+char* large_rss;
+long rss_mb = RSS_MB;
+
+static int fork_start(void) {
+    child_pid = fork();
+    if (child_pid == 0) {
+        *first_ns = monotonic_ns();
+        _exit(0);
+    }
+    return child_pid > 0 ? 0 : errno;
+}
+
+/* A child that was killed or exited non-zero never stamped (or, for
+ * posix_spawn, never reached main): EIO, so the sample is not used */
+static int pid_reap(void) {
+    int status;
+    while (waitpid(child_pid, &status, 0) < 0) {
+        if (errno != EINTR) return errno;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : EIO;
+}
+
+/* Touches every page so fork has page tables (and COW mappings) to copy */
+static int large_setup(void) {
+    size_t bytes = (size_t)rss_mb << 20;
+    large_rss = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (large_rss == MAP_FAILED) {
+        perror("mmap");
+        large_rss = NULL;
+        return -1;
+    }
+    for (size_t i = 0; i < bytes; i += 4096) large_rss[i] = (char)i;
+    return 0;
+}
+
+static void large_teardown(void) {
+    if (large_rss) munmap(large_rss, (size_t)rss_mb << 20);
+    large_rss = NULL;
+}
+
+/* The child borrows the parent's memory and stack until it exits, so it only
+ * stores the stamp and leaves */
+static int vfork_start(void) {
+    child_pid = vfork();
+    if (child_pid == 0) {
+        *first_ns = monotonic_ns();
+        _exit(0);
+    }
+    return child_pid > 0 ? 0 : errno;
+}
+
+char* clone_stack;
+
+static int clone_body(void* arg) {
+    (void)arg;
+    *first_ns = monotonic_ns();
+    return 0;
+}
+
+static int clone_setup(void) {
+    clone_stack = malloc(CLONE_STACK);
+    return clone_stack ? 0 : -1;
+}
+
+static void clone_teardown(void) { free(clone_stack); }
+
+/* A process sharing the address space, file table and fs info, but not a
+ * thread: no CLONE_THREAD, and it signals SIGCHLD on exit */
+static int clone_start(void) {
+    child_pid = clone(clone_body, clone_stack + CLONE_STACK, CLONE_VM | CLONE_FS | CLONE_FILES | SIGCHLD, NULL);
+    return child_pid > 0 ? 0 : errno;
+}
+
+/* ==================================================================================
+ * POSIX_SPAWN (re-executes this binary; the stamp is taken on entry to main,
+ * so it includes exec and dynamic loading)
+ * ================================================================================== */
+
+int stamp_fd = -1;
+
+static int spawn_setup(void) {
+    stamp_fd = memfd_create("spawn_stamp", 0);
+    if (stamp_fd < 0 || ftruncate(stamp_fd, sizeof(uint64_t)) != 0) {
+        perror("memfd_create");
+        return -1;
+    }
+    return 0;
+}
+
+static void spawn_teardown(void) {
+    if (stamp_fd >= 0) close(stamp_fd);
+    stamp_fd = -1;
+}
+
+/* The stamp is cleared first, so a child that never writes it cannot pass
+ * off the previous iteration's */
+static int spawn_start(void) {
+    char fd_arg[16];
+    uint64_t zero = 0;
+    if (pwrite(stamp_fd, &zero, sizeof(zero), 0) != (ssize_t)sizeof(zero)) return errno ? errno : EIO;
+    snprintf(fd_arg, sizeof(fd_arg), "%d", stamp_fd);
+    char* argv[] = { (char*)self_path, CHILD_FLAG, fd_arg, NULL };
+    return posix_spawn(&child_pid, self_path, NULL, NULL, argv, environ);
+}
+
+static int spawn_reap(void) {
+    int rc = pid_reap();
+    if (rc != 0) return rc;
+    uint64_t stamp = 0;
+    ssize_t n = pread(stamp_fd, &stamp, sizeof(stamp), 0);
+    if (n != (ssize_t)sizeof(stamp)) return n < 0 ? errno : EIO;
+    *first_ns = stamp;
+    return 0;
+}
+
+/* Runs in the spawned child */
+static int spawn_child(const char* fd_arg) {
+    uint64_t now = monotonic_ns();
+    return pwrite(atoi(fd_arg), &now, sizeof(now), 0) == (ssize_t)sizeof(now) ? 0 : 1;
+}
+
+static const SpawnImpl spawns[] = {
+    { "pthread",     no_setup,    thread_start, thread_reap, no_teardown },
+    { "fork",        no_setup,    fork_start,   pid_reap,    no_teardown },
+    { "fork-large",  large_setup, fork_start,   pid_reap,    large_teardown },
+    { "vfork",       no_setup,    vfork_start,  pid_reap,    no_teardown },
+    { "clone",       clone_setup, clone_start,  pid_reap,    clone_teardown },
+    { "posix_spawn", spawn_setup, spawn_start,  spawn_reap,  spawn_teardown },
+};
+
+#define NUM_SPAWNS (int)(sizeof(spawns) / sizeof(spawns[0]))
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static Percentiles percentiles(double v[], int n) {
+    Percentiles p;
+    double sum = 0;
+    qsort(v, n, sizeof(double), compare_double);
+    for (int i = 0; i < n; i++) sum += v[i];
+    p.p50 = v[(int)(0.50 * (n - 1))];
+    p.p99 = v[(int)(0.99 * (n - 1))];
+    p.p999 = v[(int)(0.999 * (n - 1))];
+    p.max = v[n - 1];
+    p.mean = sum / n;
+    return p;
+}
+
+/* start[i]: creation call to the child's first instruction; reap[i]: creation
+ * call to the child being joined / reaped. Returns 0 or the failing call's errno */
+int run_method(const SpawnImpl* s, int iters, int warmup, double start[], double reap[]) {
+    for (int i = -warmup; i < iters; i++) {
+        *first_ns = 0;
+        uint64_t t0 = monotonic_ns();
+        int rc = s->start();
+        if (rc == 0) rc = s->reap();
+        if (rc != 0) return rc;
+        uint64_t t2 = monotonic_ns();
+        if (i < 0) continue;
+        start[i] = *first_ns > t0 ? (double)(*first_ns - t0) : 0;
+        reap[i] = (double)(t2 - t0);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+    int iters = ITERS, warmup = WARMUP;
+    int selected[NUM_SPAWNS];
+    static double start[MAX_ITERS], reap[MAX_ITERS];
+
+    if (argc == 3 && strcmp(argv[1], CHILD_FLAG) == 0) return spawn_child(argv[2]);
+
+    for (int s = 0; s < NUM_SPAWNS; s++) selected[s] = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--methods") == 0 && i + 1 < argc) {
+            memset(selected, 0, sizeof(selected));
+            for (char* name = strtok(argv[++i], ","); name; name = strtok(NULL, ",")) {
+                int found = 0;
+                for (int s = 0; s < NUM_SPAWNS; s++)
+                    if (strcmp(name, spawns[s].name) == 0) selected[s] = found = 1;
+                if (!found) {
+                    fprintf(stderr, "Unknown method: %s\n", name);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = atoi(argv[++i]);
+            if (iters < 1) iters = 1;
+            if (iters > MAX_ITERS) iters = MAX_ITERS;
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+            if (warmup < 0) warmup = 0;
+        } else if (strcmp(argv[i], "--rss-mb") == 0 && i + 1 < argc) {
+            rss_mb = atol(argv[++i]);
+            if (rss_mb < 1) rss_mb = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--methods NAME,...] [--iters N] [--warmup N] [--rss-mb MB]\nMethods:", argv[0]);
+            for (int s = 0; s < NUM_SPAWNS; s++) fprintf(stderr, " %s", spawns[s].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    first_ns = mmap(NULL, sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (first_ns == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    printf("Linux Thread / Process Creation Benchmark (us; %d iterations after %d warmup, fork-large parent RSS %ld MB)\n\n",
+           iters, warmup, rss_mb);
+    printf("%-12s | %8s %8s %8s %8s | %8s %8s %8s %8s | %9s\n", "Method",
+           "start50", "start99", "st99.9", "startmax", "reap50", "reap99", "rp99.9", "reapmax", "spawns/s");
+
+    for (int s = 0; s < NUM_SPAWNS; s++) {
+        if (!selected[s]) continue;
+        if (spawns[s].setup() != 0) {
+            printf("%-12s | setup failed\n", spawns[s].name);
+            continue;
+        }
+        int rc = run_method(&spawns[s], iters, warmup, start, reap);
+        spawns[s].teardown();
+        if (rc != 0) {
+            printf("%-12s | %s\n", spawns[s].name, strerror(rc));
+            continue;
+        }
+
+        Percentiles st = percentiles(start, iters), rp = percentiles(reap, iters);
+        printf("%-12s | %8.1f %8.1f %8.1f %8.1f | %8.1f %8.1f %8.1f %8.1f | %9.0f\n", spawns[s].name,
+               st.p50 / 1e3, st.p99 / 1e3, st.p999 / 1e3, st.max / 1e3,
+               rp.p50 / 1e3, rp.p99 / 1e3, rp.p999 / 1e3, rp.max / 1e3, 1e9 / rp.mean);
+        fflush(stdout);
+    }
+
+    printf("\nstart = creation call to the child's first instruction (posix_spawn: entry to main after exec);\n"
+           "reap = creation call to pthread_join / waitpid returning. A pooled worker pays a wakeup instead.\n");
+
+    munmap((void*)first_ns, sizeof(uint64_t));
+    return 0;
+}
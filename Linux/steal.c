@@ -0,0 +1,565 @@
+/* Build: gcc -O2 -pthread steal.c -o steal -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "bench_common.h"
+
+#define MAX_THREADS 64
+#define MAX_SWEEP 64
+#define CACHE_LINE 64
+#define DEQUE_CAPACITY 8192     /* Tasks per worker deque, power of two */
+#define GLOBAL_CAPACITY 65536   /* Tasks in the global queue */
+#define FIB_N 25
+#define PFOR_ITEMS 16384
+#define PFOR_GRAIN 16           /* Items per leaf task */
+#define DURATION_MS 200
+#define WARMUP_MS 50
+#define REPS 5
+
+/* A task joins its parent when its pending count (children plus one hold
+ * for itself) drops to zero; results flow up the tree the same way */
+typedef struct Task {
+    void (*run)(struct Task* t, int wid);
+    struct Task* parent;
+    atomic_int pending;
+    atomic_long result;
+    long lo, hi;                /* fib: lo = n; parallel-for: item range */
+} Task;
+
+/* A scheduler: push() and pop() are called by the owning worker only,
+ * steal() by any worker looking for someone else's tasks */
+typedef struct {
+    const char* name;
+    void (*init)(int workers);
+    int (*push)(int wid, Task* t);     /* 0 = full, caller runs t inline */
+    Task* (*pop)(int wid);
+    Task* (*steal)(int wid);
+    void (*destroy)(void);
+} SchedImpl;
+
+typedef struct {
+    const char* name;
+    Task* (*root)(void);
+    long (*expected)(void);
+} Workload;
+
+typedef struct {
+    _Alignas(CACHE_LINE) const SchedImpl* sched;
+    int wid;
+    uint64_t rng;
+    long tasks;
+    long steals;                /* Tasks taken from another worker */
+    long attempts;              /* steal() calls, successful or not */
+} WorkerArg;
+
+typedef struct {
+    double tasks;               /* Tasks per second */
+    double steals;              /* Steals per 1000 tasks */
+    double hit;                 /* Fraction of steal attempts that got a task */
+    double jobs;                /* Root jobs completed per second */
+    double ci;
+} RoundResult;
+
+typedef struct {
+    int thread_counts[MAX_SWEEP];
+    int num_counts;
+    long duration_ms;
+    long warmup_ms;
+    int reps;
+} BenchConfig;
+
+_Alignas(CACHE_LINE) atomic_int stop_flag;
+_Alignas(CACHE_LINE) atomic_int start_flag;
+_Alignas(CACHE_LINE) atomic_int ready_count;
+_Alignas(CACHE_LINE) atomic_int job_done;
+_Alignas(CACHE_LINE) atomic_long job_result;
+WorkerArg worker_args[MAX_THREADS];
+int num_workers;
+long fib_n = FIB_N;
+long pfor_items = PFOR_ITEMS;
+
+/* ==================================================================================
+ * CHASE-LEV WORK-STEALING DEQUE (Le, Pop, Cohen, Zappa Nardelli C11 formulation)
+ * ================================================================================== */
+
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_long top;       /* Thieves take from here */
+    _Alignas(CACHE_LINE) atomic_long bottom;    /* Owner pushes and pops here */
+    _Alignas(CACHE_LINE) _Atomic(Task*) buf[DEQUE_CAPACITY];
+} Deque;
+
+Deque deques[MAX_THREADS];
+
+static void cl_init(int workers) {
+    for (int i = 0; i < workers; i++) {
+        atomic_init(&deques[i].top, 0);
+        atomic_init(&deques[i].bottom, 0);
+    }
+}
+
+static int cl_push(int wid, Task* t) {
+    Deque* d = &deques[wid];
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - top >= DEQUE_CAPACITY) return 0;
+    atomic_store_explicit(&d->buf[b & (DEQUE_CAPACITY - 1)], t, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);     /* Publishes the slot */
+    return 1;
+}
+
+static Task* cl_pop(int wid) {
+    Deque* d = &deques[wid];
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (top > b) {              /* Empty */
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    Task* t = atomic_load_explicit(&d->buf[b & (DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (top == b) {             /* Last task: race the thieves for it */
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed))
+            t = NULL;
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+/* Tries one random victim */
+static Task* cl_steal(int wid) {
+    WorkerArg* w = &worker_args[wid];
+    if (num_workers < 2) return NULL;
+
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    int victim = (int)(w->rng % (uint64_t)(num_workers - 1));
+    if (victim >= wid) victim++;
+
+    Deque* d = &deques[victim];
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= b) return NULL;
+
+    Task* t = atomic_load_explicit(&d->buf[top & (DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return t;
+}
+
+static void no_destroy(void) {}
+
+/* ==================================================================================
+ * GLOBAL QUEUE (one pthread mutex around a shared LIFO, the mutex.c pattern;
+ * LIFO keeps fib depth-first so the queue stays small)
+ * ================================================================================== */
+
+typedef struct {
+    pthread_mutex_t lock;
+    long count;
+    Task* slots[GLOBAL_CAPACITY];
+} GlobalQueue;
+
+GlobalQueue global;
+
+static void global_init(int workers) {
+    (void)workers;
+    pthread_mutex_init(&global.lock, NULL);
+    global.count = 0;
+}
+
+static int global_push(int wid, Task* t) {
+    (void)wid;
+    pthread_mutex_lock(&global.lock);
+    int ok = global.count < GLOBAL_CAPACITY;
+    if (ok) global.slots[global.count++] = t;
+    pthread_mutex_unlock(&global.lock);
+    return ok;
+}
+
+static Task* global_pop(int wid) {
+    (void)wid;
+    Task* t = NULL;
+    pthread_mutex_lock(&global.lock);
+    if (global.count > 0) t = global.slots[--global.count];
+    pthread_mutex_unlock(&global.lock);
+    return t;
+}
+
+static Task* no_steal(int wid) { (void)wid; return NULL; }
+
+static void global_destroy(void) { pthread_mutex_destroy(&global.lock); }
+
+static const SchedImpl scheds[] = {
+    { "steal",  cl_init,     cl_push,     cl_pop,     cl_steal, no_destroy },
+    { "global", global_init, global_push, global_pop, no_steal, global_destroy },
+};
+
+#define NUM_SCHEDS (int)(sizeof(scheds) / sizeof(scheds[0]))
+
+/* ==================================================================================
+ * TASKS AND WORKLOADS
+ * ================================================================================== */
+
+const SchedImpl* current_sched;
+
+static Task* task_new(void (*run)(Task*, int), Task* parent, long lo, long hi) {
+    Task* t = malloc(sizeof(Task));
+    if (!t) return NULL;
+    t->run = run;
+    t->parent = parent;
+    atomic_init(&t->pending, 1);
+    atomic_init(&t->result, 0);
+    t->lo = lo;
+    t->hi = hi;
+    return t;
+}
+
+/* Drops one hold on t; the last one hands the result to the parent */
+static void task_finish(Task* t) {
+    while (t) {
+        if (atomic_fetch_sub_explicit(&t->pending, 1, memory_order_acq_rel) != 1) return;
+        Task* parent = t->parent;
+        long result = atomic_load_explicit(&t->result, memory_order_relaxed);
+        free(t);
+        if (!parent) {
+            atomic_store_explicit(&job_result, result, memory_order_relaxed);
+            atomic_store_explicit(&job_done, 1, memory_order_release);
+            return;
+        }
+        atomic_fetch_add_explicit(&parent->result, result, memory_order_relaxed);
+        t = parent;
+    }
+}
+
+static void spawn(Task* t, int wid) {
+    if (!current_sched->push(wid, t)) {
+        worker_args[wid].tasks++;
+        t->run(t, wid);
+    }
+}
+
+/* Spawns both children of the parent before releasing its own hold. If
+ * either could not be allocated nothing is spawned and -1 tells the caller
+ * to finish t's subtree serially */
+static int spawn_pair(Task* t, Task* a, Task* b, int wid) {
+    if (!a || !b) {
+        free(a);
+        free(b);
+        return -1;
+    }
+    atomic_store_explicit(&t->pending, 3, memory_order_relaxed);
+    spawn(a, wid);
+    spawn(b, wid);
+    task_finish(t);
+    return 0;
+}
+
+static long fib_serial(long n) { return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2); }
+
+static void fib_run(Task* t, int wid) {
+    long n = t->lo;
+    if (n >= 2 && spawn_pair(t, task_new(fib_run, t, n - 1, 0), task_new(fib_run, t, n - 2, 0), wid) == 0) return;
+    atomic_store_explicit(&t->result, fib_serial(n), memory_order_relaxed);
+    task_finish(t);
+}
+
+static Task* fib_root(void) { return task_new(fib_run, NULL, fib_n, 0); }
+
+static long fib_expected(void) {
+    long a = 0, b = 1;
+    for (long i = 0; i < fib_n; i++) {
+        long c = a + b;
+        a = b;
+        b = c;
+    }
+    return a;
+}
+
+/* Item cost spans 4..512 spin units from a hash of i, and the last quarter
+ * of the range is 8x heavier again, so an even static split is badly skewed */
+static void pfor_item(long i) {
+    uint64_t h = (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+    long units = 4L << ((h >> 61) & 7);
+    if (i >= pfor_items - pfor_items / 4) units *= 8;
+
+    uint64_t x = h | 1;
+    for (long k = 0; k < units; k++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    __asm__ __volatile__("" :: "r"(x));    /* Keep the loop without a shared sink */
+}
+
+static void pfor_run(Task* t, int wid) {
+    long mid = t->lo + (t->hi - t->lo) / 2;
+    if (t->hi - t->lo > PFOR_GRAIN &&
+        spawn_pair(t, task_new(pfor_run, t, t->lo, mid), task_new(pfor_run, t, mid, t->hi), wid) == 0) return;
+    for (long i = t->lo; i < t->hi; i++) pfor_item(i);
+    atomic_store_explicit(&t->result, t->hi - t->lo, memory_order_relaxed);
+    task_finish(t);
+}
+
+static Task* pfor_root(void) { return task_new(pfor_run, NULL, 0, pfor_items); }
+static long pfor_expected(void) { return pfor_items; }
+
+static const Workload workloads[] = {
+    { "fib",  fib_root,  fib_expected },
+    { "pfor", pfor_root, pfor_expected },
+};
+
+#define NUM_WORKLOADS (int)(sizeof(workloads) / sizeof(workloads[0]))
+
+/* ==================================================================================
+ * BENCHMARK HARNESS
+ * ================================================================================== */
+
+const Workload* current_workload;
+long jobs_completed;
+long bad_results;
+
+/* Worker 0 also submits: each time a job completes it checks the answer and,
+ * unless the window has closed, pushes the next root. Everyone leaves once
+ * the window has closed and the last job has drained */
+void* worker(void* arg) {
+    WorkerArg* w = arg;
+    const SchedImpl* s = w->sched;
+    int spins = 0;
+
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire)) sched_yield();
+
+    for (;;) {
+        Task* t = s->pop(w->wid);
+        if (!t) {
+            w->attempts++;
+            t = s->steal(w->wid);
+            if (t) w->steals++;
+        }
+        if (t) {
+            w->tasks++;
+            t->run(t, w->wid);
+            spins = 0;
+            continue;
+        }
+
+        if (atomic_load_explicit(&job_done, memory_order_acquire)) {
+            int stopping = atomic_load_explicit(&stop_flag, memory_order_relaxed);
+            if (w->wid != 0) {
+                if (stopping) break;
+            } else {
+                jobs_completed++;
+                if (atomic_load_explicit(&job_result, memory_order_relaxed) != current_workload->expected())
+                    bad_results++;
+                if (stopping) break;
+                Task* root = current_workload->root();
+                if (!root) {
+                    /* Out of memory: close the window now; the others see it and leave */
+                    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+                    break;
+                }
+                atomic_store_explicit(&job_done, 0, memory_order_relaxed);
+                spawn(root, 0);
+                continue;
+            }
+        }
+        spin_wait(&spins);
+    }
+    return NULL;
+}
+
+/* One timed window; the clock stops after the in-flight job drains */
+RoundResult run_round(const SchedImpl* s, int num_threads, long duration_ms) {
+    pthread_t threads[MAX_THREADS];
+    RoundResult r = { 0, 0, 0, 0, 0 };
+
+    current_sched = s;
+    num_workers = num_threads;
+    jobs_completed = 0;
+    s->init(num_threads);
+    atomic_store(&stop_flag, 0);
+    atomic_store(&start_flag, 0);
+    atomic_store(&ready_count, 0);
+    atomic_store(&job_done, 0);
+
+    for (int i = 0; i < num_threads; i++) {
+        WorkerArg* w = &worker_args[i];
+        w->sched = s;
+        w->wid = i;
+        w->rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+        w->tasks = w->steals = w->attempts = 0;
+    }
+    Task* root = current_workload->root();
+    if (!root) {
+        perror("malloc");
+        exit(1);
+    }
+    spawn(root, 0);
+    for (int i = 0; i < num_threads; i++) {
+        int rc = pthread_create(&threads[i], NULL, worker, &worker_args[i]);
+        if (rc != 0) {
+            /* Those already started finish the root job between them, then leave */
+            atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+            atomic_store_explicit(&start_flag, 1, memory_order_release);
+            while (--i >= 0) pthread_join(threads[i], NULL);
+            s->destroy();
+            fprintf(stderr, "%s: %s\n", s->name, strerror(rc));
+            exit(1);
+        }
+    }
+
+    while (atomic_load(&ready_count) < num_threads) sched_yield();
+    double start = get_time_sec();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    sleep_ms(duration_ms);
+    atomic_store_explicit(&stop_flag, 1, memory_order_relaxed);
+    for (int i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    double end = get_time_sec();
+    s->destroy();
+
+    long tasks = 0, steals = 0, attempts = 0;
+    for (int i = 0; i < num_threads; i++) {
+        tasks += worker_args[i].tasks;
+        steals += worker_args[i].steals;
+        attempts += worker_args[i].attempts;
+    }
+
+    r.tasks = tasks / (end - start);
+    r.jobs = jobs_completed / (end - start);
+    r.steals = tasks ? 1000.0 * steals / tasks : 0;
+    r.hit = attempts ? (double)steals / attempts : 0;
+    return r;
+}
+
+/* Warmup window, then reps windows; returns the median one with a 95% CI */
+RoundResult measure(const SchedImpl* s, int num_threads, const BenchConfig* cfg) {
+    static RoundResult reps[MAX_REPS];
+    double rate[MAX_REPS];
+
+    if (cfg->warmup_ms > 0) run_round(s, num_threads, cfg->warmup_ms);
+    for (int i = 0; i < cfg->reps; i++) {
+        reps[i] = run_round(s, num_threads, cfg->duration_ms);
+        rate[i] = reps[i].tasks;
+    }
+
+    RepSummary sum = summarize_reps(rate, cfg->reps);
+    RoundResult r = reps[sum.median_rep];
+    r.tasks = sum.median;
+    r.ci = sum.ci;
+    return r;
+}
+
+/* Default sweep: powers of two up to the online CPUs, plus exactly that many */
+void default_thread_counts(BenchConfig* cfg) {
+    int online = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    if (online > MAX_THREADS) online = MAX_THREADS;
+
+    cfg->num_counts = 0;
+    for (int n = 1; n <= online; n++)
+        if ((n & (n - 1)) == 0 || n == online) cfg->thread_counts[cfg->num_counts++] = n;
+}
+
+static int select_names(char* list, const char* what, int* selected, int count,
+                        const char* (*name_of)(int)) {
+    memset(selected, 0, count * sizeof(int));
+    for (char* name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        int found = 0;
+        for (int i = 0; i < count; i++)
+            if (strcmp(name, name_of(i)) == 0) selected[i] = found = 1;
+        if (!found) {
+            fprintf(stderr, "Unknown %s: %s\n", what, name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static const char* sched_name(int i) { return scheds[i].name; }
+static const char* workload_name(int i) { return workloads[i].name; }
+
+int main(int argc, char* argv[]) {
+
+    BenchConfig cfg = { .duration_ms = DURATION_MS, .warmup_ms = WARMUP_MS, .reps = REPS };
+    int use_sched[NUM_SCHEDS], use_workload[NUM_WORKLOADS];
+
+    for (int s = 0; s < NUM_SCHEDS; s++) use_sched[s] = 1;
+    for (int k = 0; k < NUM_WORKLOADS; k++) use_workload[k] = 1;
+    default_thread_counts(&cfg);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scheds") == 0 && i + 1 < argc) {
+            if (select_names(argv[++i], "scheduler", use_sched, NUM_SCHEDS, sched_name) != 0) return 1;
+        } else if (strcmp(argv[i], "--workloads") == 0 && i + 1 < argc) {
+            if (select_names(argv[++i], "workload", use_workload, NUM_WORKLOADS, workload_name) != 0) return 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if ((cfg.num_counts = parse_thread_list(argv[++i], cfg.thread_counts, MAX_SWEEP, MAX_THREADS)) < 0) return 1;
+        } else if (strcmp(argv[i], "--fib") == 0 && i + 1 < argc) {
+            fib_n = atol(argv[++i]);
+            if (fib_n < 2) fib_n = 2;
+            if (fib_n > 40) fib_n = 40;
+        } else if (strcmp(argv[i], "--items") == 0 && i + 1 < argc) {
+            pfor_items = atol(argv[++i]);
+            if (pfor_items < PFOR_GRAIN) pfor_items = PFOR_GRAIN;
+        } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            cfg.duration_ms = atol(argv[++i]);
+            if (cfg.duration_ms < 1) cfg.duration_ms = 1;
+        } else if (strcmp(argv[i], "--warmup-ms") == 0 && i + 1 < argc) {
+            cfg.warmup_ms = atol(argv[++i]);
+            if (cfg.warmup_ms < 0) cfg.warmup_ms = 0;
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = atoi(argv[++i]);
+            if (cfg.reps < 1) cfg.reps = 1;
+            if (cfg.reps > MAX_REPS) cfg.reps = MAX_REPS;
+        } else {
+            fprintf(stderr, "Usage: %s [--scheds NAME,...] [--workloads fib,pfor] [--threads N,...]\n"
+                    "          [--fib N] [--items N] [--duration-ms MS] [--warmup-ms MS] [--reps N]\nSchedulers:",
+                    argv[0]);
+            for (int s = 0; s < NUM_SCHEDS; s++) fprintf(stderr, " %s", scheds[s].name);
+            fprintf(stderr, "\n");
+            return 1;
+        }
+    }
+
+    printf("Linux Work-Stealing Benchmark (Mtasks/sec: median ±95%% CI of %d x %ld ms windows)\n",
+           cfg.reps, cfg.duration_ms);
+
+    for (int k = 0; k < NUM_WORKLOADS; k++) {
+        if (!use_workload[k]) continue;
+        current_workload = &workloads[k];
+        if (k == 0) printf("\nfib(%ld)\n\n", fib_n);
+        else printf("\nParallel-for, %ld uneven items, grain %d\n\n", pfor_items, PFOR_GRAIN);
+        printf("%-8s %-8s %17s %10s %10s %8s\n", "Threads", "Sched", "Mtasks/sec", "jobs/sec", "steals/1k", "hit %");
+
+        for (int t = 0; t < cfg.num_counts; t++) {
+            for (int s = 0; s < NUM_SCHEDS; s++) {
+                if (!use_sched[s]) continue;
+                bad_results = 0;
+                RoundResult r = measure(&scheds[s], cfg.thread_counts[t], &cfg);
+                printf("%-8d %-8s %9.3f ±%6.3f %10.1f", cfg.thread_counts[t], scheds[s].name,
+                       r.tasks / 1e6, r.ci / 1e6, r.jobs);
+                if (scheds[s].steal == no_steal) printf(" %10s %8s\n", "-", "-");
+                else printf(" %10.2f %8.1f\n", r.steals, 100.0 * r.hit);
+                if (bad_results) fprintf(stderr, "%s: %ld jobs returned a wrong result\n", scheds[s].name, bad_results);
+                fflush(stdout);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* Build: gcc -O2 -pthread wakeup.c -o wakeup -lm */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "bench_common.h"
+
+#define MAX_TIMERS 64
+#define MAX_LOAD 256
+#define INTERVAL_US 1000        /* Period of timer thread 0 */
+#define DISTANCE_US 500         /* Each further timer thread's period is this much longer */
+#define DURATION_MS 5000
+
+/* Timer thread i wakes every interval + i * distance us at FIFO priority
+ * prio - i (never below 1), or SCHED_OTHER when prio is 0, like cyclictest */
+typedef struct {
+    int id;
+    long period_ns;
+    int prio;
+    long samples;
+    long overruns;              /* Periods missed outright */
+    double sum_ns;
+    uint64_t max_ns;
+    long hist[HIST_BUCKETS];
+} TimerArg;
+
+typedef enum { REPORT_TEXT, REPORT_CSV } ReportFormat;
+
+_Alignas(64) atomic_int stop_flag;
+TimerArg timers[MAX_TIMERS];
+ReportFormat report_format = REPORT_TEXT;
+
+/* ==================================================================================
+ * TIMER AND LOAD THREADS
+ * ================================================================================== */
+
+/* Sleeps to an absolute deadline and records how late the wakeup was: the
+ * kernel's response time for a task that became runnable at the deadline */
+void* timer_thread(void* arg) {
+    TimerArg* t = arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        next.tv_nsec += t->period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) ;
+
+        uint64_t now = monotonic_ns();
+        uint64_t deadline = (uint64_t)next.tv_sec * 1000000000ULL + next.tv_nsec;
+        uint64_t late = now > deadline ? now - deadline : 0;
+        t->hist[hist_bucket(late)]++;
+        t->sum_ns += (double)late;
+        if (late > t->max_ns) t->max_ns = late;
+        t->samples++;
+
+        /* Woke more than a whole period late: skip the deadlines already gone */
+        if (late >= (uint64_t)t->period_ns) {
+            long missed = (long)(late / (uint64_t)t->period_ns);
+            t->overruns += missed;
+            uint64_t skip = (uint64_t)missed * t->period_ns + deadline;
+            next.tv_sec = (time_t)(skip / 1000000000ULL);
+            next.tv_nsec = (long)(skip % 1000000000ULL);
+        }
+    }
+    return NULL;
+}
+
+/* Background CPU load at SCHED_OTHER: spins, touching a private buffer */
+void* load_thread(void* arg) {
+    (void)arg;
+    size_t size = 256 * 1024, i = 0;
+    volatile char* buf = calloc(size, 1);
+    if (!buf) return NULL;
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        buf[i] += 1;
+        i = (i + 64) % size;
+    }
+    free((void*)buf);
+    return NULL;
+}
+
+static int start_thread(pthread_t* thread, void* (*fn)(void*), void* arg, int prio) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (prio > 0) {
+        struct sched_param param = { .sched_priority = prio };
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    int rc = pthread_create(thread, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+/* ==================================================================================
+ * REPORTING (ms, in the RT columns cw11 prints for simulated response time)
+ * ================================================================================== */
+
+static void print_row(const char* name, long period_ns, int prio, const long hist[], long samples,
+                      double sum_ns, uint64_t max_ns, long overruns) {
+    double mean = samples ? sum_ns / samples / 1e6 : 0;
+    double p50 = hist_percentile(hist, samples, 50) / 1e6;
+    double p99 = hist_percentile(hist, samples, 99) / 1e6;
+    double p999 = hist_percentile(hist, samples, 99.9) / 1e6;
+
+    char period[16], policy[16];
+    if (report_format == REPORT_CSV) {
+        /* The pooled row has no period or priority: leave those fields empty */
+        period[0] = policy[0] = '\0';
+        if (period_ns > 0) snprintf(period, sizeof(period), "%.3f", period_ns / 1e6);
+        if (prio >= 0) snprintf(policy, sizeof(policy), "%d", prio);
+        printf("%s,%s,%s,%ld,%.6f,%.6f,%.6f,%.6f,%.6f,%ld\n", name, period, policy, samples,
+               mean, p50, p99, p999, max_ns / 1e6, overruns);
+        return;
+    }
+    if (period_ns > 0) snprintf(period, sizeof(period), "%.3f", period_ns / 1e6);
+    else strcpy(period, "-");
+    if (prio > 0) snprintf(policy, sizeof(policy), "FIFO %d", prio);
+    else strcpy(policy, prio == 0 ? "OTHER" : "-");
+    printf("%-6s %-10s %-8s %9ld %-8.3f %-8.3f %-8.3f %-8.3f %-8.3f %8ld\n", name, period, policy, samples,
+           mean, p50, p99, p999, max_ns / 1e6, overruns);
+}
+
+int main(int argc, char* argv[]) {
+
+    int num_timers = 1, num_load = 0, prio = 0, lock_memory = 1;
+    long interval_us = INTERVAL_US, distance_us = DISTANCE_US, duration_ms = DURATION_MS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_timers = atoi(argv[++i]);
+            if (num_timers < 1) num_timers = 1;
+            if (num_timers > MAX_TIMERS) num_timers = MAX_TIMERS;
+        } else if (strcmp(argv[i], "--interval-us") == 0 && i + 1 < argc) {
+            interval_us = atol(argv[++i]);
+            if (interval_us < 10) interval_us = 10;
+        } else if (strcmp(argv[i], "--distance-us") == 0 && i + 1 < argc) {
+            distance_us = atol(argv[++i]);
+            if (distance_us < 0) distance_us = 0;
+        } else if (strcmp(argv[i], "--prio") == 0 && i + 1 < argc) {
+            prio = atoi(argv[++i]);
+            if (prio < 0) prio = 0;
+            if (prio > 99) prio = 99;
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            num_load = atoi(argv[++i]);
+            if (num_load < 0) num_load = 0;
+            if (num_load > MAX_LOAD) num_load = MAX_LOAD;
+        } else if (strcmp(argv[i], "--duration-ms") == 0 && i + 1 < argc) {
+            duration_ms = atol(argv[++i]);
+            if (duration_ms < 1) duration_ms = 1;
+        } else if (strcmp(argv[i], "--no-mlock") == 0) {
+            lock_memory = 0;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "csv") == 0) report_format = REPORT_CSV;
+            else if (strcmp(argv[i], "text") == 0) report_format = REPORT_TEXT;
+            else {
+                fprintf(stderr, "Unknown format: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--threads N] [--interval-us US] [--distance-us US] [--prio P]\n"
+                    "          [--load N] [--duration-ms MS] [--no-mlock] [--format text|csv]\n"
+                    "Timer thread i wakes every interval + i * distance us at SCHED_FIFO prio - i\n"
+                    "(SCHED_OTHER when --prio is 0); --load adds SCHED_OTHER spinning threads\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Page faults in the timer loop would show up as wakeup latency */
+    if (lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) perror("mlockall (continuing)");
+
+    pthread_t timer_threads[MAX_TIMERS], load_threads[MAX_LOAD];
+    int started = 0, loaded = 0;
+    atomic_store(&stop_flag, 0);
+
+    for (int i = 0; i < num_load; i++) {
+        if (start_thread(&load_threads[loaded], load_thread, NULL, 0) != 0) break;
+        loaded++;
+    }
+    for (int i = 0; i < num_timers; i++) {
+        TimerArg* t = &timers[i];
+        memset(t, 0, sizeof(*t));
+        t->id = i;
+        t->period_ns = (interval_us + i * distance_us) * 1000L;
+        t->prio = prio > 0 ? (prio - i > 0 ? prio - i : 1) : 0;
+        int rc = start_thread(&timer_threads[i], timer_thread, t, t->prio);
+        if (rc != 0) {
+            fprintf(stderr, "Timer thread %d: %s%s\n", i, strerror(rc),
+                    rc == EPERM ? " (SCHED_FIFO needs CAP_SYS_NICE; try --prio 0)" : "");
+            break;
+        }
+        started++;
+    }
+
+    struct timespec window = { duration_ms / 1000, (duration_ms % 1000) * 1000000L };
+    if (started > 0) while (nanosleep(&window, &window) != 0) ;
+    atomic_store(&stop_flag, 1);
+    for (int i = 0; i < started; i++) pthread_join(timer_threads[i], NULL);
+    for (int i = 0; i < loaded; i++) pthread_join(load_threads[i], NULL);
+    if (started == 0) return 1;
+
+    static long all_hist[HIST_BUCKETS];
+    long all_samples = 0, all_overruns = 0;
+    double all_sum = 0;
+    uint64_t all_max = 0;
+    for (int i = 0; i < started; i++) {
+        for (int b = 0; b < HIST_BUCKETS; b++) all_hist[b] += timers[i].hist[b];
+        all_samples += timers[i].samples;
+        all_overruns += timers[i].overruns;
+        all_sum += timers[i].sum_ns;
+        if (timers[i].max_ns > all_max) all_max = timers[i].max_ns;
+    }
+
+    if (report_format == REPORT_CSV) {
+        printf("thread,period_ms,prio,samples,mean_rt,p50_rt,p99_rt,p999_rt,max_rt,overruns\n");
+    } else {
+        printf("Linux Wakeup Latency Probe (RT = actual minus scheduled wakeup, ms; %ld ms, %d load thread%s)\n\n",
+               duration_ms, loaded, loaded == 1 ? "" : "s");
+        printf("%-6s %-10s %-8s %9s %-8s %-8s %-8s %-8s %-8s %8s\n", "Thread", "Period", "Policy", "Samples",
+               "RT(ms)", "p50 RT", "p99 RT", "p99.9 RT", "max RT", "Overruns");
+    }
+    for (int i = 0; i < started; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "T%d", i);
+        print_row(name, timers[i].period_ns, timers[i].prio, timers[i].hist, timers[i].samples,
+                  timers[i].sum_ns, timers[i].max_ns, timers[i].overruns);
+    }
+    print_row("all", 0, -1, all_hist, all_samples, all_sum, all_max, all_overruns);
+
+    if (report_format == REPORT_TEXT)
+        printf("\nObserved: p99 RT %.3f ms | mean RT %.3f ms (compare cw11 --tune output and RT(ms) columns)\n",
+               hist_percentile(all_hist, all_samples, 99) / 1e6, all_samples ? all_sum / all_samples / 1e6 : 0);
+    return 0;
+}